@@ -0,0 +1,312 @@
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include <juce_events/juce_events.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+// Microbenchmarks for the DSP hot paths. Every configuration prints the cost per
+// sample and what share of one core it would take to run in real time at 48 kHz.
+//
+//   ParametricEqualizer100Benchmark [--quick]
+
+namespace {
+
+constexpr double benchmarkSampleRate = 48000.0;
+double minSecondsPerMeasurement = 0.25;
+
+volatile float sink = 0.0f;
+
+// Seconds per call of fn, after a warm-up, doubling the iteration count until one
+// run takes long enough to be trusted.
+double secondsPerCall(const std::function<void()>& fn) {
+    using Clock = std::chrono::steady_clock;
+
+    for (int i = 0; i < 8; ++i)
+        fn();
+
+    for (long iterations = 1;; iterations *= 2) {
+        const auto start = Clock::now();
+        for (long i = 0; i < iterations; ++i)
+            fn();
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (elapsed >= minSecondsPerMeasurement)
+            return elapsed / (double) iterations;
+    }
+}
+
+// The same, with setup run before every call and left out of the time
+double secondsPerCall(const std::function<void()>& setup, const std::function<void()>& fn) {
+    using Clock = std::chrono::steady_clock;
+
+    for (int i = 0; i < 8; ++i) {
+        setup();
+        fn();
+    }
+
+    for (long iterations = 1;; iterations *= 2) {
+        double elapsed = 0.0;
+        for (long i = 0; i < iterations; ++i) {
+            setup();
+            const auto start = Clock::now();
+            fn();
+            elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        if (elapsed >= minSecondsPerMeasurement)
+            return elapsed / (double) iterations;
+    }
+}
+
+// samplesPerCall counts sample frames, so for multichannel cases the CPU figure is
+// per instance and the ns figure is per frame (all channels).
+void report(const char* name, double seconds, int samplesPerCall) {
+    const double nsPerSample = seconds * 1.0e9 / samplesPerCall;
+    const double realtimeSeconds = samplesPerCall / benchmarkSampleRate;
+    std::printf("  %-44s %9.2f ns/sample %8.3f %% CPU\n",
+                name, nsPerSample, 100.0 * seconds / realtimeSeconds);
+}
+
+juce::AudioChannelSet channelSetFor(int numChannels) {
+    auto set = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    return set.isDisabled() ? juce::AudioChannelSet::discreteChannels(numChannels) : set;
+}
+
+void fillWithNoise(juce::AudioBuffer<float>& buffer) {
+    juce::Random random(1234);
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        for (int n = 0; n < buffer.getNumSamples(); ++n)
+            buffer.setSample(channel, n, random.nextFloat() * 0.5f - 0.25f);
+}
+
+//==============================================================================
+template <typename SampleType, typename StateType>
+void benchmarkProcessSample(const char* name) {
+    BiquadFilter<SampleType, StateType> filter;
+    auto c = AudioPluginAudioProcessor::makePeaking(benchmarkSampleRate, 1000.0, 0.707, 6.0);
+    filter.setCoefficients(c[0], c[1], c[2], c[3], c[4], c[5]);
+
+    constexpr int numSamples = 4096;
+    std::vector<SampleType> input(numSamples);
+    juce::Random random(42);
+    for (auto& x : input)
+        x = (SampleType) (random.nextFloat() - 0.5f);
+
+    const double seconds = secondsPerCall([&] {
+        SampleType acc = 0;
+        for (auto x : input)
+            acc += filter.processSample(x);
+        sink = (float) acc;
+    });
+    report(name, seconds, numSamples);
+}
+
+void benchmarkDesigners() {
+    std::printf("\nCoefficient designers (one call designs one band)\n");
+
+    const auto time = [](const char* name, auto&& design) {
+        double freq = 100.0;
+        const double seconds = secondsPerCall([&] {
+            // Vary the input so nothing gets hoisted out of the loop
+            freq = freq > 15000.0 ? 100.0 : freq * 1.001;
+            sink = (float) design(freq)[0];
+        });
+        std::printf("  %-44s %9.2f ns/call\n", name, seconds * 1.0e9);
+    };
+
+    using P = AudioPluginAudioProcessor;
+    time("makeHighPass", [](double f) { return P::makeHighPass(benchmarkSampleRate, f, 0.707); });
+    time("makeLowPass", [](double f) { return P::makeLowPass(benchmarkSampleRate, f, 0.707); });
+    time("makeBandPass", [](double f) { return P::makeBandPass(benchmarkSampleRate, f, 1.0); });
+    time("makePeaking", [](double f) { return P::makePeaking(benchmarkSampleRate, f, 1.0, 6.0); });
+    time("makeLowShelf", [](double f) { return P::makeLowShelf(benchmarkSampleRate, f, 0.707, 6.0); });
+    time("makeHighShelf", [](double f) { return P::makeHighShelf(benchmarkSampleRate, f, 0.707, 6.0); });
+
+    // Every band of an instance at once, scalar and batched
+    time("5 bands, make* (per call)", [](double f) {
+        std::array<double,6> c = P::makeHighPass(benchmarkSampleRate, f, 0.707);
+        c[0] += P::makePeaking(benchmarkSampleRate, f * 1.1, 1.0, 6.0)[0];
+        c[0] += P::makeLowShelf(benchmarkSampleRate, f * 1.2, 0.707, 6.0)[0];
+        c[0] += P::makeHighShelf(benchmarkSampleRate, f * 1.3, 0.707, -6.0)[0];
+        c[0] += P::makeLowPass(benchmarkSampleRate, f * 1.4, 0.707)[0];
+        return c;
+    });
+
+    BatchDesigner batch;
+    batch.reserve(5);
+    time("5 bands, BatchDesigner (per call)", [&batch](double f) {
+        batch.clear();
+        batch.add(FilterType::highPass, benchmarkSampleRate, f, 0.707);
+        batch.add(FilterType::peaking, benchmarkSampleRate, f * 1.1, 1.0, 6.0);
+        batch.add(FilterType::lowShelf, benchmarkSampleRate, f * 1.2, 0.707, 6.0);
+        batch.add(FilterType::highShelf, benchmarkSampleRate, f * 1.3, 0.707, -6.0);
+        batch.add(FilterType::lowPass, benchmarkSampleRate, f * 1.4, 0.707);
+        batch.design();
+        return batch.getCoefficients(0);
+    });
+}
+
+//==============================================================================
+// Session load: setStateInformation with a full state, alternating between two
+// so every call really changes some parameters
+void benchmarkStateLoad() {
+    std::printf("\nState\n");
+
+    AudioPluginAudioProcessor processor;
+    std::array<juce::MemoryBlock, 2> states;
+    for (size_t i = 0; i < states.size(); ++i) {
+        for (int band = 0; band < AudioPluginAudioProcessor::maxBands; ++band) {
+            auto* gain = processor.getValueTreeState().getParameter(
+                    AudioPluginAudioProcessor::getBandParameterID(band, "GAIN"));
+            gain->setValueNotifyingHost(gain->convertTo0to1(i == 0 ? 3.0f : -3.0f));
+        }
+        processor.getStateInformation(states[i]);
+    }
+
+    size_t next = 0;
+    const double seconds = secondsPerCall([&] {
+        const auto& state = states[next];
+        processor.setStateInformation(state.getData(), (int) state.getSize());
+        next ^= 1;
+    });
+    std::printf("  %-44s %9.2f us/call (%d bytes)\n", "setStateInformation",
+                seconds * 1.0e6, (int) states[0].getSize());
+}
+
+//==============================================================================
+// Full processBlock. With automate set, every band parameter gets a new value
+// before every block, which is the worst case for the coefficient path. The
+// processor runs non-realtime, so the coefficients are designed inline and
+// timed with the block instead of on the design thread; setting the parameters
+// (and the listener calls that come with it) isn't timed.
+// passSlope is the slope of the default high and low pass, in dB/oct, and
+// stateVariable runs the bands as SVFs instead of biquads.
+void benchmarkProcessBlock(int numChannels, int blockSize, bool automate,
+                           int oversamplingIndex = 0, int numBands = 5, int passSlope = 12,
+                           bool stateVariable = false) {
+    AudioPluginAudioProcessor processor;
+    processor.setNonRealtime(true);
+    auto& apvts = processor.getValueTreeState();
+    auto* oversampling = apvts.getParameter("OVERSAMPLING");
+    oversampling->setValueNotifyingHost(oversampling->convertTo0to1((float) oversamplingIndex));
+    apvts.getParameter("ENGINE")->setValueNotifyingHost(stateVariable ? 1.0f : 0.0f);
+
+    const auto& slopes = AudioPluginAudioProcessor::passSlopes;
+    const auto slopeIndex = (float) (std::find(slopes.begin(), slopes.end(), passSlope) - slopes.begin());
+    for (int band : { 0, 4 }) {
+        auto* slope = apvts.getParameter(AudioPluginAudioProcessor::getBandParameterID(band, "SLOPE"));
+        slope->setValueNotifyingHost(slope->convertTo0to1(slopeIndex));
+    }
+
+    // Only the first numBands bands are on
+    for (int band = 0; band < AudioPluginAudioProcessor::maxBands; ++band)
+        apvts.getParameter(AudioPluginAudioProcessor::getBandParameterID(band, "ON"))
+            ->setValueNotifyingHost(band < numBands ? 1.0f : 0.0f);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSetFor(numChannels));
+    layout.outputBuses.add(channelSetFor(numChannels));
+
+    const auto name = juce::String(numChannels) + " ch, block " + juce::String(blockSize)
+                    + (automate ? ", automated" : "")
+                    + (oversamplingIndex > 0 ? ", " + oversampling->getCurrentValueAsText() : "")
+                    + (numBands != 5 ? ", " + juce::String(numBands) + " bands" : "")
+                    + (passSlope != 12 ? ", HP/LP " + juce::String(passSlope) + " dB/oct" : "")
+                    + (stateVariable ? ", SVF" : "");
+
+    if (! processor.setBusesLayout(layout)) {
+        std::printf("  %-44s (layout not supported)\n", name.toRawUTF8());
+        return;
+    }
+
+    processor.setRateAndBufferSizeDetails(benchmarkSampleRate, blockSize);
+    processor.prepareToPlay(benchmarkSampleRate, blockSize);
+
+    juce::AudioBuffer<float> input(numChannels, blockSize), buffer(numChannels, blockSize);
+    juce::MidiBuffer midi;
+    fillWithNoise(input);
+
+    // Mode switches, band types, channels, slopes and on/off aren't automation a
+    // session would do every block
+    juce::Array<juce::AudioProcessorParameter*> params;
+    for (auto* param : processor.getParameters()) {
+        const auto id = dynamic_cast<juce::AudioProcessorParameterWithID&>(*param).paramID;
+        if (id.startsWith("BAND") && ! id.endsWith("TYPE") && ! id.endsWith("ON")
+            && ! id.endsWith("CHANNEL") && ! id.endsWith("SLOPE") && ! id.endsWith("ALIGN"))
+            params.add(param);
+    }
+    juce::Random random(7);
+
+    const double seconds = secondsPerCall([&] {
+        if (automate)
+            for (auto* param : params)
+                param->setValueNotifyingHost(random.nextFloat());
+
+        // Fresh input every time, so the signal can't build up or decay into
+        // denormals over many runs
+        buffer.makeCopyOf(input, true);
+    }, [&] {
+        processor.processBlock(buffer, midi);
+    });
+
+    report(name.toRawUTF8(), seconds, blockSize);
+
+    processor.releaseResources();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    if (argc > 1 && juce::String(argv[1]) == "--quick")
+        minSecondsPerMeasurement = 0.02;
+
+    std::printf("ParametricEqualizer100 DSP benchmarks (%.0f Hz)\n", benchmarkSampleRate);
+
+    std::printf("\nBiquadFilter::processSample, one band, one channel\n");
+    benchmarkProcessSample<float, double>("BiquadFilter<float, double>");
+    benchmarkProcessSample<float, float>("BiquadFilter<float, float>");
+
+    benchmarkDesigners();
+    benchmarkStateLoad();
+
+    const int blockSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const int channelCounts[] = { 1, 2, 6, 12 };
+
+    for (bool automate : { false, true }) {
+        std::printf("\nprocessBlock, default settings%s\n",
+                    automate ? ", every parameter automated every block" : "");
+        for (int numChannels : channelCounts)
+            for (int blockSize : blockSizes)
+                benchmarkProcessBlock(numChannels, blockSize, automate);
+    }
+
+    std::printf("\nprocessBlock, default settings, oversampled\n");
+    for (int oversamplingIndex : { 1, 2 })
+        for (int numChannels : { 2, 6 })
+            for (int blockSize : { 64, 512 })
+                benchmarkProcessBlock(numChannels, blockSize, false, oversamplingIndex);
+
+    // The cascade skips bands that are off, so this should grow with the count
+    std::printf("\nprocessBlock, bands on out of %d\n", AudioPluginAudioProcessor::maxBands);
+    for (int numBands : { 1, 5, 12, 24 })
+        for (bool automate : { false, true })
+            benchmarkProcessBlock(2, 512, automate, 0, numBands);
+
+    // A steep pass is several sections, run in pairs
+    std::printf("\nprocessBlock, default settings, steeper high and low pass\n");
+    for (int passSlope : { 12, 24, 48, 96 })
+        for (bool automate : { false, true })
+            benchmarkProcessBlock(2, 512, automate, 0, 5, passSlope);
+
+    // The SVF engine against the biquads, ramping g and k per sample when automated
+    std::printf("\nprocessBlock, default settings, state-variable engine\n");
+    for (int blockSize : { 64, 512 })
+        for (bool automate : { false, true })
+            for (bool stateVariable : { false, true })
+                benchmarkProcessBlock(2, blockSize, automate, 0, 5, 12, stateVariable);
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+//==============================================================================
+// The controls of one band, stacked in a narrow strip: on/off, type, channel,
+// slope and alignment, then frequency, gain and Q, and the dynamics below them.
+// The editor makes one per band.
+class BandComponent final : public juce::Component {
+public:
+    BandComponent(juce::AudioProcessorValueTreeState&, int band);
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+    static constexpr int preferredWidth = 90;
+
+private:
+    using SliderAttachment = juce::AudioProcessorValueTreeState::SliderAttachment;
+    using ComboBoxAttachment = juce::AudioProcessorValueTreeState::ComboBoxAttachment;
+
+    // Pass filters have no gain, and so no dynamics either; only they have a slope
+    void updateEnablement();
+
+    juce::String title;
+
+    juce::ToggleButton enabledButton;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> enabledAttachment;
+
+    juce::ComboBox typeBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> typeAttachment;
+
+    juce::ComboBox channelBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> channelAttachment;
+
+    juce::ComboBox slopeBox, alignmentBox;
+    std::unique_ptr<ComboBoxAttachment> slopeAttachment, alignmentAttachment;
+
+    juce::Slider freqSlider, gainSlider, qSlider;
+    std::unique_ptr<SliderAttachment> freqAttachment, gainAttachment, qAttachment;
+
+    // Dynamics
+    juce::ToggleButton dynamicButton;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> dynamicAttachment;
+
+    juce::Slider thresholdSlider, ratioSlider, attackSlider, releaseSlider;
+    std::unique_ptr<SliderAttachment> thresholdAttachment, ratioAttachment, attackAttachment, releaseAttachment;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandComponent)
+};
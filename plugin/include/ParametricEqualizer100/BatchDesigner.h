@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "SvfFilter.h"
+
+// Branch-free replacements for the libm calls in the RBJ designers. Plain
+// arithmetic only, so a loop calling them over arrays vectorises.
+namespace FastMath {
+
+// sin and cos of x for x in [0, pi], i.e. anything from 0 Hz to Nyquist.
+// Taylor series of x/2 (to x^19 for sin, x^20 for cos), then the double-angle
+// formulas. At x/2 = pi/2 the truncation is below 3e-16, so the absolute error
+// of both results stays under 1e-14 over the whole range.
+inline void sinCos(double x, double& s, double& c) noexcept {
+    const double h = 0.5 * x;
+    const double h2 = h * h;
+
+    const double sh = h * (1.0 + h2 * (-1.0 / 6.0 + h2 * (1.0 / 120.0 + h2 * (-1.0 / 5040.0
+                    + h2 * (1.0 / 362880.0 + h2 * (-1.0 / 39916800.0 + h2 * (1.0 / 6227020800.0
+                    + h2 * (-1.0 / 1307674368000.0 + h2 * (1.0 / 355687428096000.0
+                    + h2 * (-1.0 / 121645100408832000.0))))))))));
+    const double ch = 1.0 + h2 * (-1.0 / 2.0 + h2 * (1.0 / 24.0 + h2 * (-1.0 / 720.0
+                    + h2 * (1.0 / 40320.0 + h2 * (-1.0 / 3628800.0 + h2 * (1.0 / 479001600.0
+                    + h2 * (-1.0 / 87178291200.0 + h2 * (1.0 / 20922789888000.0
+                    + h2 * (-1.0 / 6402373705728000.0 + h2 * (1.0 / 2432902008176640000.0))))))))));
+
+    s = 2.0 * sh * ch;
+    c = 1.0 - 2.0 * sh * sh;
+}
+
+// e^x for |x| < 708. Splits x into k ln2 + r with |r| <= ln2 / 2, takes e^r from
+// its Taylor series to r^12 (truncation below 4e-16) and builds 2^k in the
+// exponent bits. Relative error under 5e-15.
+inline double exp(double x) noexcept {
+    constexpr double log2e = 1.4426950408889634;
+    constexpr double ln2hi = 0.6931471805599453;
+    constexpr double ln2lo = 2.3190468138462996e-17;
+    // Adding 1.5 * 2^52 rounds to an integer that lands in the low mantissa bits
+    constexpr double shifter = 6755399441055744.0;
+
+    const double t = x * log2e + shifter;
+    const double k = t - shifter;
+    const double r = (x - k * ln2hi) - k * ln2lo;
+
+    const double p = 1.0 + r * (1.0 + r * (1.0 / 2.0 + r * (1.0 / 6.0 + r * (1.0 / 24.0
+                   + r * (1.0 / 120.0 + r * (1.0 / 720.0 + r * (1.0 / 5040.0 + r * (1.0 / 40320.0
+                   + r * (1.0 / 362880.0 + r * (1.0 / 3628800.0 + r * (1.0 / 39916800.0
+                   + r * (1.0 / 479001600.0))))))))))));
+
+    const auto exponent = std::bit_cast<std::int64_t>(t) - std::bit_cast<std::int64_t>(shifter);
+    return p * std::bit_cast<double>((exponent + 1023) << 52);
+}
+
+} // namespace FastMath
+
+// The filter shapes the designer knows, one per make* function
+enum class FilterType { lowPass, highPass, peaking, lowShelf, highShelf, bandPass,
+                        firstOrderLowPass, firstOrderHighPass };
+
+// Designs many biquads at once: every band of an instance, or of many instances
+// when rendering in batch. Bands are queued into structure-of-arrays inputs; the
+// transcendental part (sin/cos of w0 and the gain's 10^(dB/40)) runs as one
+// vectorisable pass over all of them, and the per-type cookbook formulas after
+// it are only a few multiplies each. Normalised results match the make*
+// functions to 1e-12 of the largest coefficient.
+class BatchDesigner {
+public:
+    // clear() and add() don't allocate until more bands than this are queued
+    void reserve(int maxBands) {
+        const auto n = (size_t) maxBands;
+        types.reserve(n);
+        for (auto* v : { &sampleRates, &freqs, &qs, &gains, &sinw, &cosw, &amp, &sqrtAmp,
+                         &b0, &b1, &b2, &a0, &a1, &a2 })
+            v->reserve(n);
+    }
+
+    void clear() {
+        types.clear();
+        for (auto* v : { &sampleRates, &freqs, &qs, &gains })
+            v->clear();
+    }
+
+    // Queues a band and returns its index into the results. Frequencies past
+    // Nyquist are designed at Nyquist, which keeps w0 within [0, pi] where
+    // FastMath::sinCos() holds its bound.
+    int add(FilterType type, double sampleRate, double freq, double Q, double dBgain = 0.0) {
+        types.push_back(type);
+        sampleRates.push_back(sampleRate);
+        freqs.push_back(std::min(freq, 0.5 * sampleRate));
+        qs.push_back(Q);
+        gains.push_back(dBgain);
+        return (int) types.size() - 1;
+    }
+
+    int size() const { return (int) types.size(); }
+
+    void design() {
+        const auto n = types.size();
+        for (auto* v : { &sinw, &cosw, &amp, &sqrtAmp, &b0, &b1, &b2, &a0, &a1, &a2 })
+            v->resize(n);
+
+        // Transcendentals for every band, whatever its type
+        designTranscendentals(freqs.data(), sampleRates.data(), gains.data(),
+                              sinw.data(), cosw.data(), amp.data(), sqrtAmp.data(), n);
+
+        for (size_t i = 0; i < n; ++i)
+            designOne(i);
+    }
+
+    // { b0, b1, b2, a0, a1, a2 }, like the make* functions
+    std::array<double,6> getCoefficients(int index) const {
+        const auto i = (size_t) index;
+        return { b0[i], b1[i], b2[i], a0[i], a1[i], a2[i] };
+    }
+
+    // The same design as a state-variable section, like makeSvf(). tan(w0 / 2)
+    // comes from the sin and cos already there, so it costs no transcendental.
+    SvfCoefficients<double> getSvfCoefficients(int index) const {
+        const auto i = (size_t) index;
+        const double s = sinw[i], c = cosw[i];
+
+        // Whichever form doesn't cancel: sin / (1 + cos) up to fs / 4, then
+        // (1 - cos) / sin, which only runs off to infinity at Nyquist itself
+        const double g = c >= 0.0 ? s / (1.0 + c) : (1.0 - c) / std::max(s, 0.0);
+        return designSvf(types[i], std::min(g, svfMaxG), qs[i], amp[i], sqrtAmp[i]);
+    }
+
+    // The analog prototype of each type, at g = tan(w0 / 2) and the cookbook's
+    // A and sqrt(A). Shelves move g by sqrt(A), where their poles are.
+    static SvfCoefficients<double> designSvf(FilterType type, double g, double Q, double A, double sqrtA) {
+        using Svf = SvfCoefficients<double>;
+        switch (type) {
+            case FilterType::lowPass:   return Svf::fromPrototype(g, 1.0 / Q, 0.0, 0.0, 1.0);
+            case FilterType::highPass:  return Svf::fromPrototype(g, 1.0 / Q, 1.0, 0.0, 0.0);
+            case FilterType::bandPass:  return Svf::fromPrototype(g, 1.0 / Q, 0.0, 1.0 / Q, 0.0);
+            case FilterType::peaking:   return Svf::fromPrototype(g, 1.0 / (Q * A), 1.0, A / Q, 1.0);
+            case FilterType::lowShelf:
+            case FilterType::highShelf: {
+                // Q is the shelf slope here too, see designOne()
+                const double k = std::sqrt((A + 1.0 / A) * (1.0 / Q - 1.0) + 2.0);
+                return type == FilterType::lowShelf
+                     ? Svf::fromPrototype(g / sqrtA, k, 1.0, A * k, A * A)
+                     : Svf::fromPrototype(g * sqrtA, k, A * A, A * k, 1.0);
+            }
+            // A real pole, as the double pole of a critically damped section with
+            // one of the two cancelled by a zero
+            case FilterType::firstOrderLowPass:  return Svf::fromPrototype(g, 2.0, 0.0, 1.0, 1.0);
+            case FilterType::firstOrderHighPass: return Svf::fromPrototype(g, 2.0, 1.0, 1.0, 0.0);
+        }
+        return Svf::identity();
+    }
+
+private:
+    // sin/cos of w0 and A = 10^(dB/40) for n bands. Kept apart from the members so
+    // the compiler can see the arrays don't alias the vectors holding them.
+    static void designTranscendentals(const double* freq, const double* rate, const double* gain,
+                                      double* sinOut, double* cosOut, double* ampOut,
+                                      double* sqrtAmpOut, size_t n) noexcept {
+        constexpr double twoPi = 6.283185307179586476925;
+        constexpr double ln10over80 = 0.028782313662425574;   // ln(10) / 80
+
+        for (size_t i = 0; i < n; ++i) {
+            double s, c;
+            FastMath::sinCos(twoPi * freq[i] / rate[i], s, c);
+            const double sqrtA = FastMath::exp(gain[i] * ln10over80);  // sqrt(A) = 10^(dB/80)
+            sinOut[i] = s;
+            cosOut[i] = c;
+            sqrtAmpOut[i] = sqrtA;
+            ampOut[i] = sqrtA * sqrtA;                                 // A = 10^(dB/40)
+        }
+    }
+
+    // The RBJ cookbook, from the precomputed sin/cos/A
+    void designOne(size_t i) {
+        const double s = sinw[i], c = cosw[i], A = amp[i], sqrtA = sqrtAmp[i];
+
+        switch (types[i]) {
+            case FilterType::lowPass:
+            case FilterType::highPass: {
+                const double alpha = s / (2.0 * qs[i]);
+                const double sign = types[i] == FilterType::lowPass ? -1.0 : 1.0;
+                b0[i] = (1.0 + sign * c) * 0.5;
+                b1[i] = -sign * (1.0 + sign * c);
+                b2[i] = b0[i];
+                a0[i] = 1.0 + alpha;
+                a1[i] = -2.0 * c;
+                a2[i] = 1.0 - alpha;
+                break;
+            }
+            case FilterType::bandPass: {
+                const double alpha = s / (2.0 * qs[i]);
+                b0[i] = alpha;
+                b1[i] = 0.0;
+                b2[i] = -alpha;
+                a0[i] = 1.0 + alpha;
+                a1[i] = -2.0 * c;
+                a2[i] = 1.0 - alpha;
+                break;
+            }
+            case FilterType::peaking: {
+                const double alpha = s / (2.0 * qs[i]);
+                b0[i] = 1.0 + alpha * A;
+                b1[i] = -2.0 * c;
+                b2[i] = 1.0 - alpha * A;
+                a0[i] = 1.0 + alpha / A;
+                a1[i] = -2.0 * c;
+                a2[i] = 1.0 - alpha / A;
+                break;
+            }
+            case FilterType::lowShelf:
+            case FilterType::highShelf: {
+                // The high shelf is the low shelf with cos w0 (and b1/a1) negated
+                const double sign = types[i] == FilterType::lowShelf ? 1.0 : -1.0;
+                const double cs = sign * c;
+                const double alpha = s / 2.0 * std::sqrt((A + 1.0 / A) * (1.0 / qs[i] - 1.0) + 2.0);
+                const double twoSqrtAAlpha = 2.0 * sqrtA * alpha;
+                b0[i] = A * ((A + 1.0) - (A - 1.0) * cs + twoSqrtAAlpha);
+                b1[i] = sign * 2.0 * A * ((A - 1.0) - (A + 1.0) * cs);
+                b2[i] = A * ((A + 1.0) - (A - 1.0) * cs - twoSqrtAAlpha);
+                a0[i] = (A + 1.0) + (A - 1.0) * cs + twoSqrtAAlpha;
+                a1[i] = -sign * 2.0 * ((A - 1.0) + (A + 1.0) * cs);
+                a2[i] = (A + 1.0) + (A - 1.0) * cs - twoSqrtAAlpha;
+                break;
+            }
+            case FilterType::firstOrderLowPass:
+            case FilterType::firstOrderHighPass: {
+                // sin and cos of w0 / 2 from the half-angle formula for the larger
+                // one, which doesn't cancel, and sin w0 = 2 sin cos for the other
+                double sh, ch;
+                if (c >= 0.0) {
+                    ch = std::sqrt(0.5 * (1.0 + c));
+                    sh = s / (2.0 * ch);
+                }
+                else {
+                    sh = std::sqrt(0.5 * (1.0 - c));
+                    ch = s / (2.0 * sh);
+                }
+                const double g = types[i] == FilterType::firstOrderLowPass ? sh : ch;
+                const double sign = types[i] == FilterType::firstOrderLowPass ? 1.0 : -1.0;
+                b0[i] = g;
+                b1[i] = sign * g;
+                b2[i] = 0.0;
+                a0[i] = sh + ch;
+                a1[i] = sh - ch;
+                a2[i] = 0.0;
+                break;
+            }
+        }
+    }
+
+    // Inputs
+    std::vector<FilterType> types;
+    std::vector<double> sampleRates, freqs, qs, gains;
+
+    // Intermediates and outputs
+    std::vector<double> sinw, cosw, amp, sqrtAmp;
+    std::vector<double> b0, b1, b2, a0, a1, a2;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+// Compact, versioned plugin state. A 12 byte header (magic, version, entry
+// count), then one 8 byte entry per parameter: a hash of its ID and its plain
+// value, all little endian. Parameters are matched by ID, so a state keeps
+// loading when parameters are added, removed or reordered: unknown entries are
+// skipped and parameters missing from the state keep their value.
+namespace BinaryState {
+
+constexpr juce::uint32 magic = 0x53514550;    // "PEQS"
+constexpr juce::uint32 currentVersion = 1;
+constexpr size_t headerSize = 12;
+constexpr size_t entrySize = 8;
+
+struct Entry {
+    juce::uint32 idHash;
+    float value;
+};
+
+// FNV-1a of the UTF-8 ID: stable across builds and platforms
+juce::uint32 hashParameterID(const juce::String& id);
+
+void write(const std::vector<Entry>& entries, juce::MemoryBlock& dest);
+
+// Fills entries (reusing its capacity) and returns true if data holds a state
+// this version can read
+bool read(const void* data, size_t size, std::vector<Entry>& entries);
+
+} // namespace BinaryState
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+#include "BiquadFilter.h"
+
+// Channels packed into SIMD lanes. Channel c lives in lane (c % laneWidth) of
+// group (c / laneWidth), and every group is stored as a contiguous run of frames,
+// so a filter steps through a whole block with one register load per sample.
+template <typename FloatType>
+class ChannelLanes {
+public:
+    using Vec = juce::dsp::SIMDRegister<FloatType>;
+    static constexpr int laneWidth = (int) Vec::SIMDNumElements;
+
+    static int numGroupsFor(int numChannels) {
+        return (numChannels + laneWidth - 1) / laneWidth;
+    }
+
+    void prepare(int numChannelsToUse, int maxSamplesToUse) {
+        numChannels = numChannelsToUse;
+        maxSamples = maxSamplesToUse;
+        frames.assign((size_t) (numGroupsFor(numChannels) * maxSamples),
+                      Vec::expand((FloatType) 0));
+    }
+
+    int getNumChannels() const { return numChannels; }
+    int getNumGroups() const { return numGroupsFor(numChannels); }
+    int getMaxSamples() const { return maxSamples; }
+
+    Vec* getGroup(int group) { return frames.data() + group * maxSamples; }
+
+    // Copies numSamples samples from each channel into the lanes. Lanes past the
+    // last channel are zeroed so they stay silent through the filters. With
+    // midSide, the first two channels go in as mid (L + R) / 2 and side
+    // (L - R) / 2, encoded on the way in.
+    template <typename SampleType>
+    void gather(const SampleType* const* channels, int numChannelsToRead,
+                int startSample, int numSamples, bool midSide = false) {
+        jassert(numSamples <= maxSamples);
+        for (int group = 0; group < getNumGroups(); ++group) {
+            auto* raw = reinterpret_cast<FloatType*>(getGroup(group));
+            int lane = 0;
+            if (midSide && group == 0 && laneWidth >= 2 && numChannelsToRead >= 2) {
+                const SampleType* left = channels[0] + startSample;
+                const SampleType* right = channels[1] + startSample;
+                for (int n = 0; n < numSamples; ++n) {
+                    const auto l = (FloatType) left[n], r = (FloatType) right[n];
+                    raw[n * laneWidth] = (FloatType) 0.5 * (l + r);
+                    raw[n * laneWidth + 1] = (FloatType) 0.5 * (l - r);
+                }
+                lane = 2;
+            }
+
+            for (; lane < laneWidth; ++lane) {
+                const int channel = group * laneWidth + lane;
+                if (channel < numChannelsToRead) {
+                    const SampleType* src = channels[channel] + startSample;
+                    for (int n = 0; n < numSamples; ++n)
+                        raw[n * laneWidth + lane] = (FloatType) src[n];
+                }
+                else {
+                    for (int n = 0; n < numSamples; ++n)
+                        raw[n * laneWidth + lane] = (FloatType) 0;
+                }
+            }
+        }
+    }
+
+    // Inverse of gather(): writes the lanes back out to the channels, decoding
+    // mid and side back to left and right.
+    template <typename SampleType>
+    void scatter(SampleType* const* channels, int numChannelsToWrite,
+                 int startSample, int numSamples, bool midSide = false) {
+        for (int group = 0; group < getNumGroups(); ++group) {
+            const auto* raw = reinterpret_cast<const FloatType*>(getGroup(group));
+            int lane = 0;
+            if (midSide && group == 0 && laneWidth >= 2 && numChannelsToWrite >= 2) {
+                SampleType* left = channels[0] + startSample;
+                SampleType* right = channels[1] + startSample;
+                for (int n = 0; n < numSamples; ++n) {
+                    const auto mid = raw[n * laneWidth], side = raw[n * laneWidth + 1];
+                    left[n] = (SampleType) (mid + side);
+                    right[n] = (SampleType) (mid - side);
+                }
+                lane = 2;
+            }
+
+            for (; lane < laneWidth; ++lane) {
+                const int channel = group * laneWidth + lane;
+                if (channel >= numChannelsToWrite)
+                    break;
+                SampleType* dst = channels[channel] + startSample;
+                for (int n = 0; n < numSamples; ++n)
+                    dst[n] = (SampleType) raw[n * laneWidth + lane];
+            }
+        }
+    }
+
+private:
+    int numChannels = 0;
+    int maxSamples = 0;
+    std::vector<Vec> frames;
+};
+
+// One biquad applied to every channel at once. All channels share a single set of
+// coefficients but each lane keeps its own state, so left and right (or any other
+// channels) never leak into each other's filter memory.
+template <typename FloatType>
+class BiquadBank {
+public:
+    using Vec = juce::dsp::SIMDRegister<FloatType>;
+
+    void prepare(int numGroups) {
+        state.assign((size_t) numGroups, State{});
+    }
+
+    void reset() {
+        for (auto& s : state)
+            s = State{};
+    }
+
+    // Jumps straight to a new set of coefficients.
+    void setCoefficients(
+            double b0_, double b1_, double b2_,
+            double a0_, double a1_, double a2_
+            ) {
+        const auto c = BiquadCoefficients<double>::normalised(b0_, b1_, b2_, a0_, a1_, a2_);
+        coefs = expand(c);
+        target = coefs;
+        neutral = targetNeutral = c.isIdentity(identityTolerance);
+        ramping = false;
+    }
+
+    // Moves linearly to a new set of coefficients over the next rampLength samples.
+    // The state is left alone, so the filter keeps ringing through the change
+    // instead of clicking. Every group has to be processed with exactly rampLength
+    // samples, then commitRamp() lands on the target.
+    void setTargetCoefficients(
+            double b0_, double b1_, double b2_,
+            double a0_, double a1_, double a2_,
+            int rampLength
+            ) {
+        const auto c = BiquadCoefficients<double>::normalised(b0_, b1_, b2_, a0_, a1_, a2_);
+        target = expand(c);
+        targetNeutral = c.isIdentity(identityTolerance);
+
+        // Moving between two identity filters is inaudible, so there is nothing to ramp
+        if (neutral && targetNeutral) {
+            coefs = target;
+            ramping = false;
+            return;
+        }
+
+        const auto inv = (FloatType) 1 / (FloatType) rampLength;
+        step = { (target.b0 - coefs.b0) * inv, (target.b1 - coefs.b1) * inv,
+                 (target.b2 - coefs.b2) * inv, (target.a1 - coefs.a1) * inv,
+                 (target.a2 - coefs.a2) * inv };
+        ramping = true;
+    }
+
+    void commitRamp() {
+        coefs = target;
+        neutral = targetNeutral;
+        ramping = false;
+    }
+
+    bool isRamping() const { return ramping; }
+
+    // True when the filter currently does nothing to the signal and isn't about
+    // to, so it can be skipped entirely.
+    bool isNeutral() const { return neutral && ! ramping; }
+
+    void process(Vec* frames, int numSamples, int group) noexcept {
+        auto& s = state[(size_t) group];
+        Vec s1 = s.s1, s2 = s.s2;
+
+        if (ramping) {
+            auto c = coefs;
+            for (int n = 0; n < numSamples; ++n) {
+                c.b0 += step.b0; c.b1 += step.b1; c.b2 += step.b2;
+                c.a1 += step.a1; c.a2 += step.a2;
+                frames[n] = processBiquadTDF2(frames[n], c, s1, s2);
+            }
+        }
+        else {
+            for (int n = 0; n < numSamples; ++n)
+                frames[n] = processBiquadTDF2(frames[n], coefs, s1, s2);
+        }
+
+        s.s1 = s1;
+        s.s2 = s2;
+    }
+
+private:
+    struct State {
+        Vec s1 = Vec::expand((FloatType) 0);
+        Vec s2 = Vec::expand((FloatType) 0);
+    };
+
+    static constexpr double identityTolerance = 1.0e-12;
+
+    template <typename T>
+    static BiquadCoefficients<Vec> expand(const BiquadCoefficients<T>& c) {
+        return { Vec::expand((FloatType) c.b0), Vec::expand((FloatType) c.b1),
+                 Vec::expand((FloatType) c.b2), Vec::expand((FloatType) c.a1),
+                 Vec::expand((FloatType) c.a2) };
+    }
+
+    BiquadCoefficients<Vec> coefs = expand(BiquadCoefficients<FloatType>::identity());
+    BiquadCoefficients<Vec> target = coefs;
+    BiquadCoefficients<Vec> step = coefs;
+    bool ramping = false;
+    bool neutral = true, targetNeutral = true;
+
+    std::vector<State> state;
+};
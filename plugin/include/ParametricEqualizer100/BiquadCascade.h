@@ -0,0 +1,293 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include "BiquadBank.h"
+
+// A chain of biquad sections run over a block in one pass. Each section sweeps the
+// whole (L1-sized) block before the next one starts, so its coefficients and state
+// stay in registers. Sections that are currently an identity filter are left out
+// of the chain until their coefficients move again, so the cost follows the number
+// of bands in use rather than how many there could be.
+//
+// Two settled sections next to each other in the chain run in the same sample
+// loop. Each one's recursion is a chain of dependent multiply-adds that leaves
+// the core mostly waiting, and the second section's doesn't wait on the first's
+// beyond the sample passed between them, so interleaving the pair keeps both
+// chains in flight at once. That is what keeps the many sections of a steep
+// high or low pass from costing as many passes.
+//
+// Everything is stored as structure of arrays: one array per coefficient across
+// sections, and the state of all sections of a channel group side by side. A
+// group's pass through the chain reads two short contiguous runs.
+//
+// Coefficients are held per lane, so a section can filter some lanes and pass
+// the others through: the two channels (or mid and side) of a stereo pair each
+// get their own bands in the same pass.
+template <typename FloatType>
+class BiquadCascade {
+public:
+    using Vec = juce::dsp::SIMDRegister<FloatType>;
+
+    // One bit per lane of a group: the lanes a section filters
+    using LaneMask = juce::uint32;
+    static constexpr LaneMask allLanes = ~LaneMask(0);
+    static constexpr int numLanes = (int) Vec::SIMDNumElements;
+
+    void prepare(int numSectionsToUse, int numGroupsToUse) {
+        numSections = numSectionsToUse;
+        numGroups = numGroupsToUse;
+
+        const auto n = (size_t) numSections;
+        const auto identity = expand(BiquadCoefficients<FloatType>::identity());
+        for (auto* c : { &current, &target, &step })
+            c->assign(n, identity);
+        ramping.assign(n, false);
+        neutral.assign(n, true);
+        targetNeutral.assign(n, true);
+
+        s1.assign(n * (size_t) numGroups, Vec::expand((FloatType) 0));
+        s2.assign(n * (size_t) numGroups, Vec::expand((FloatType) 0));
+
+        active.assign(n, false);
+        activeSections.clear();
+        activeSections.reserve(n);
+        numActive = 0;
+        activeChanged = false;
+    }
+
+    void reset() {
+        std::fill(s1.begin(), s1.end(), Vec::expand((FloatType) 0));
+        std::fill(s2.begin(), s2.end(), Vec::expand((FloatType) 0));
+    }
+
+    int getNumSections() const { return numSections; }
+    int getNumActiveSections() const { return numActive; }
+
+    // Samples for the active sections, run one after another, to ring down by
+    // decayDb: the sum of each one's decay, taking the slowest lane and the slower
+    // of where a ramping section is and where it's going.
+    double getDecaySamples(double decayDb) const {
+        double samples = 0;
+        for (size_t i = 0; i < (size_t) numSections; ++i) {
+            if (! active[i])
+                continue;
+            double decay = 0;
+            for (int lane = 0; lane < numLanes; ++lane) {
+                decay = std::max(decay, getLane(current, i, lane).getDecaySamples(decayDb));
+                if (ramping[i])
+                    decay = std::max(decay, getLane(target, i, lane).getDecaySamples(decayDb));
+            }
+            samples += decay;
+        }
+        return samples;
+    }
+
+    // Jumps straight to a new set of coefficients, in the given lanes.
+    void setCoefficients(
+            int section,
+            double b0, double b1, double b2,
+            double a0, double a1, double a2,
+            LaneMask lanes = allLanes
+            ) {
+        const auto i = (size_t) section;
+        const auto c = BiquadCoefficients<double>::normalised(b0, b1, b2, a0, a1, a2);
+        current.set(i, expand(c, lanes));
+        target.set(i, current.get(i));
+        neutral[i] = targetNeutral[i] = isNeutral(c, lanes);
+        ramping[i] = false;
+        updateActive(i);
+    }
+
+    // Moves linearly to a new set of coefficients over the next rampLength samples,
+    // leaving the state alone so the section rings through the change. Every group
+    // has to be processed with exactly rampLength samples, then commitRamps() lands
+    // every ramping section on its target.
+    void setTargetCoefficients(
+            int section,
+            double b0, double b1, double b2,
+            double a0, double a1, double a2,
+            int rampLength,
+            LaneMask lanes = allLanes
+            ) {
+        const auto i = (size_t) section;
+        const auto c = BiquadCoefficients<double>::normalised(b0, b1, b2, a0, a1, a2);
+        target.set(i, expand(c, lanes));
+        targetNeutral[i] = isNeutral(c, lanes);
+
+        // Moving between two identity filters is inaudible, so there is nothing to ramp
+        if (neutral[i] && targetNeutral[i]) {
+            current.set(i, target.get(i));
+            ramping[i] = false;
+            updateActive(i);
+            return;
+        }
+
+        const auto inv = Vec::expand((FloatType) 1 / (FloatType) rampLength);
+        step.b0[i] = (target.b0[i] - current.b0[i]) * inv;
+        step.b1[i] = (target.b1[i] - current.b1[i]) * inv;
+        step.b2[i] = (target.b2[i] - current.b2[i]) * inv;
+        step.a1[i] = (target.a1[i] - current.a1[i]) * inv;
+        step.a2[i] = (target.a2[i] - current.a2[i]) * inv;
+        ramping[i] = true;
+        updateActive(i);
+    }
+
+    void commitRamps() {
+        for (size_t i = 0; i < (size_t) numSections; ++i) {
+            if (ramping[i]) {
+                current.set(i, target.get(i));
+                neutral[i] = targetNeutral[i];
+                ramping[i] = false;
+                updateActive(i);
+            }
+        }
+    }
+
+    void process(Vec* frames, int numSamples, int group) noexcept {
+        if (activeChanged)
+            rebuildActiveSections();
+
+        Vec* groupS1 = s1.data() + group * numSections;
+        Vec* groupS2 = s2.data() + group * numSections;
+
+        for (size_t k = 0; k < activeSections.size(); ++k) {
+            const auto i = (size_t) activeSections[k];
+
+            const bool paired = k + 1 < activeSections.size()
+                            && ! ramping[i] && ! ramping[(size_t) activeSections[k + 1]];
+            if (paired) {
+                const auto j = (size_t) activeSections[++k];
+                Vec z1a = groupS1[i], z2a = groupS2[i], z1b = groupS1[j], z2b = groupS2[j];
+                const auto ca = current.get(i), cb = current.get(j);
+                for (int n = 0; n < numSamples; ++n) {
+                    const Vec y = processBiquadTDF2(frames[n], ca, z1a, z2a);
+                    frames[n] = processBiquadTDF2(y, cb, z1b, z2b);
+                }
+
+                groupS1[i] = z1a; groupS2[i] = z2a;
+                groupS1[j] = z1b; groupS2[j] = z2b;
+                continue;
+            }
+
+            Vec z1 = groupS1[i], z2 = groupS2[i];
+            auto c = current.get(i);
+
+            if (ramping[i]) {
+                const auto d = step.get(i);
+                for (int n = 0; n < numSamples; ++n) {
+                    c.b0 += d.b0; c.b1 += d.b1; c.b2 += d.b2;
+                    c.a1 += d.a1; c.a2 += d.a2;
+                    frames[n] = processBiquadTDF2(frames[n], c, z1, z2);
+                }
+            }
+            else {
+                for (int n = 0; n < numSamples; ++n)
+                    frames[n] = processBiquadTDF2(frames[n], c, z1, z2);
+            }
+
+            groupS1[i] = z1;
+            groupS2[i] = z2;
+        }
+    }
+
+private:
+    // One array per coefficient, indexed by section
+    struct CoefficientArrays {
+        std::vector<Vec> b0, b1, b2, a1, a2;
+
+        void assign(size_t n, const BiquadCoefficients<Vec>& c) {
+            b0.assign(n, c.b0); b1.assign(n, c.b1); b2.assign(n, c.b2);
+            a1.assign(n, c.a1); a2.assign(n, c.a2);
+        }
+
+        BiquadCoefficients<Vec> get(size_t i) const {
+            return { b0[i], b1[i], b2[i], a1[i], a2[i] };
+        }
+
+        void set(size_t i, const BiquadCoefficients<Vec>& c) {
+            b0[i] = c.b0; b1[i] = c.b1; b2[i] = c.b2;
+            a1[i] = c.a1; a2[i] = c.a2;
+        }
+    };
+
+    static constexpr double identityTolerance = 1.0e-12;
+
+    static constexpr LaneMask laneBits = (LaneMask(1) << numLanes) - 1;
+
+    template <typename T>
+    static BiquadCoefficients<Vec> expand(const BiquadCoefficients<T>& c) {
+        return { Vec::expand((FloatType) c.b0), Vec::expand((FloatType) c.b1),
+                 Vec::expand((FloatType) c.b2), Vec::expand((FloatType) c.a1),
+                 Vec::expand((FloatType) c.a2) };
+    }
+
+    // c in the given lanes, identity in the rest
+    static BiquadCoefficients<Vec> expand(const BiquadCoefficients<double>& c, LaneMask lanes) {
+        if ((lanes & laneBits) == laneBits)
+            return expand(c);
+
+        auto v = expand(BiquadCoefficients<FloatType>::identity());
+        for (int lane = 0; lane < numLanes; ++lane) {
+            if ((lanes >> lane) & 1) {
+                const auto l = (size_t) lane;
+                v.b0.set(l, (FloatType) c.b0); v.b1.set(l, (FloatType) c.b1);
+                v.b2.set(l, (FloatType) c.b2); v.a1.set(l, (FloatType) c.a1);
+                v.a2.set(l, (FloatType) c.a2);
+            }
+        }
+        return v;
+    }
+
+    static bool isNeutral(const BiquadCoefficients<double>& c, LaneMask lanes) {
+        return (lanes & laneBits) == 0 || c.isIdentity(identityTolerance);
+    }
+
+    static BiquadCoefficients<double> getLane(const CoefficientArrays& c, size_t i, int lane) {
+        const auto l = (size_t) lane;
+        return { (double) c.b0[i].get(l), (double) c.b1[i].get(l), (double) c.b2[i].get(l),
+                 (double) c.a1[i].get(l), (double) c.a2[i].get(l) };
+    }
+
+    void updateActive(size_t i) {
+        const bool isActive = ! neutral[i] || ramping[i];
+        if (active[i] == isActive)
+            return;
+
+        // A section dropping out takes its leftover state with it, so it comes
+        // back from silence instead of replaying an old tail
+        if (! isActive) {
+            for (int group = 0; group < numGroups; ++group) {
+                s1[(size_t) (group * numSections) + i] = Vec::expand((FloatType) 0);
+                s2[(size_t) (group * numSections) + i] = Vec::expand((FloatType) 0);
+            }
+        }
+
+        active[i] = isActive;
+        numActive += isActive ? 1 : -1;
+        activeChanged = true;
+    }
+
+    // The chain is only rebuilt before the next pass, however many sections
+    // changed since the last one
+    void rebuildActiveSections() noexcept {
+        activeSections.clear();
+        for (size_t i = 0; i < (size_t) numSections; ++i)
+            if (active[i])
+                activeSections.push_back((int) i);
+        activeChanged = false;
+    }
+
+    int numSections = 0, numGroups = 0;
+
+    CoefficientArrays current, target, step;
+    std::vector<bool> ramping, neutral, targetNeutral;
+
+    // State, [group * numSections + section]
+    std::vector<Vec> s1, s2;
+
+    std::vector<bool> active;
+    std::vector<int> activeSections;
+    int numActive = 0;
+    bool activeChanged = false;
+};
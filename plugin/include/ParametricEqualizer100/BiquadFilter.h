@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Biquad coefficients, already divided through by a0 so the per-sample kernel
+// never has to. T is a plain floating-point type or a SIMD register.
+template <typename T>
+struct BiquadCoefficients {
+    T b0, b1, b2, a1, a2;
+
+    static BiquadCoefficients normalised(
+            double b0_, double b1_, double b2_,
+            double a0_, double a1_, double a2_
+            ) {
+        const double inv = 1.0 / a0_;
+        return { (T) (b0_ * inv), (T) (b1_ * inv), (T) (b2_ * inv),
+                 (T) (a1_ * inv), (T) (a2_ * inv) };
+    }
+
+    static BiquadCoefficients identity() {
+        return { (T) 1, (T) 0, (T) 0, (T) 0, (T) 0 };
+    }
+
+    // True when the filter passes its input through untouched, i.e. the numerator
+    // equals the denominator: a bell or shelf at 0 dB, a high pass at 0 Hz or a
+    // low pass at Nyquist.
+    bool isIdentity(T tolerance) const {
+        const auto near = [tolerance](T a, T b) { return (a > b ? a - b : b - a) <= tolerance; };
+        return near(b0, (T) 1) && near(b1, a1) && near(b2, a2);
+    }
+
+    // |H(e^jw)| at w radians per sample, from cos w alone:
+    // |b0 + b1 e^-jw + b2 e^-2jw|^2 = b0^2 + b1^2 + b2^2 + 2 (b0 b1 + b1 b2) cos w + 2 b0 b2 cos 2w
+    T getMagnitude(T w) const {
+        const T cosw = std::cos(w), cos2w = std::cos((T) 2 * w);
+        const T num = b0 * b0 + b1 * b1 + b2 * b2 + (T) 2 * (b0 * b1 + b1 * b2) * cosw + (T) 2 * b0 * b2 * cos2w;
+        const T den = (T) 1 + a1 * a1 + a2 * a2 + (T) 2 * (a1 + a1 * a2) * cosw + (T) 2 * a2 * cos2w;
+        return std::sqrt(std::max(num, (T) 0) / den);
+    }
+
+    // Samples until the impulse response has fallen by decayDb (negative), set by
+    // the pole furthest from the origin: sqrt(a2) for a complex pair, the larger
+    // root otherwise. Infinite for a filter that doesn't decay.
+    double getDecaySamples(double decayDb) const {
+        const double disc = (double) a1 * a1 - 4.0 * a2;
+        const double radius = disc < 0.0 ? std::sqrt((double) a2)
+                                         : 0.5 * (std::abs((double) a1) + std::sqrt(disc));
+        if (radius >= 1.0)
+            return std::numeric_limits<double>::infinity();
+
+        // The two zeros last two samples even without any poles
+        return 2.0 + (radius > 0.0 ? decayDb / (20.0 * std::log10(radius)) : 0.0);
+    }
+};
+
+// One step of a Transposed Direct Form II biquad. TDF-II keeps the state small
+// when the poles sit close to the unit circle, which is what makes a float state
+// usable at all for low-frequency, high-Q bands.
+// The same kernel runs on scalars and on SIMD registers.
+template <typename T>
+inline T processBiquadTDF2(T x, const BiquadCoefficients<T>& c, T& s1, T& s2) noexcept {
+    T y = c.b0 * x + s1;
+    s1 = c.b1 * x - c.a1 * y + s2;
+    s2 = c.b2 * x - c.a2 * y;
+    return y;
+}
+
+// Single channel biquad. SampleType is what goes in and out, StateType is what the
+// arithmetic and state run in: BiquadFilter<float> computes in double like the
+// original filter did, BiquadFilter<float, float> stays in float throughout.
+template <typename SampleType, typename StateType = double>
+struct BiquadFilter {
+    BiquadCoefficients<StateType> coefs = BiquadCoefficients<StateType>::identity();
+
+    // State:
+    StateType s1 = 0, s2 = 0;
+
+    void setCoefficients(
+            double b0_, double b1_, double b2_,
+            double a0_, double a1_, double a2_
+            ) {
+        coefs = BiquadCoefficients<StateType>::normalised(b0_, b1_, b2_, a0_, a1_, a2_);
+    }
+
+    void reset() {
+        s1 = 0;
+        s2 = 0;
+    }
+
+    SampleType processSample(SampleType x) {
+        return (SampleType) processBiquadTDF2((StateType) x, coefs, s1, s2);
+    }
+};
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+// Histogram of non-negative integers that one thread records into and any
+// thread reads, without locks. Small values get a bucket each; from 16 up there
+// are eight buckets per octave, so any value is known to within 12.5%.
+// Recording is a handful of relaxed loads and stores: there is only ever one
+// writer, so no read-modify-write is needed.
+class StatisticsHistogram {
+public:
+    static constexpr int numLinearBuckets = 16;
+    static constexpr int stepBits = 3;
+    static constexpr int bucketsPerOctave = 1 << stepBits;
+    static constexpr int numBuckets = numLinearBuckets + 40 * bucketsPerOctave;
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+    struct Summary {
+        std::uint64_t count = 0;
+        double p50 = 0, p99 = 0, max = 0;
+    };
+
+    // Writer side
+    void record(std::uint64_t value) noexcept {
+        auto& bucket = counts[(size_t) getBucket(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > maxValue.load(std::memory_order_relaxed))
+            maxValue.store(value, std::memory_order_relaxed);
+    }
+
+    void clear() noexcept {
+        for (auto& bucket : counts)
+            bucket.store(0, std::memory_order_relaxed);
+        maxValue.store(0, std::memory_order_relaxed);
+    }
+
+    // Reader side. Percentiles are the top of the bucket they fall in, never more
+    // than the largest value seen; every value is multiplied by scale.
+    Summary summarise(double scale = 1.0) const noexcept {
+        std::array<std::uint64_t, numBuckets> snapshot;
+        std::uint64_t total = 0;
+        for (size_t i = 0; i < snapshot.size(); ++i)
+            total += snapshot[i] = counts[i].load(std::memory_order_relaxed);
+
+        Summary summary;
+        summary.count = total;
+        if (total == 0)
+            return summary;
+
+        const auto largest = maxValue.load(std::memory_order_relaxed);
+        const auto percentile = [&](double fraction) {
+            const auto rank = (std::uint64_t) std::ceil(fraction * (double) total);
+            std::uint64_t seen = 0;
+            for (int i = 0; i < numBuckets; ++i) {
+                seen += snapshot[(size_t) i];
+                if (seen >= rank)
+                    return (double) std::min(getBucketTop(i), largest) * scale;
+            }
+            return (double) largest * scale;
+        };
+
+        summary.p50 = percentile(0.5);
+        summary.p99 = percentile(0.99);
+        summary.max = (double) largest * scale;
+        return summary;
+    }
+
+    static int getBucket(std::uint64_t value) noexcept {
+        if (value < (std::uint64_t) numLinearBuckets)
+            return (int) value;
+
+        const int octave = (int) std::bit_width(value) - 1;
+        const int step = (int) ((value >> (octave - stepBits)) & (bucketsPerOctave - 1));
+        return std::min(numLinearBuckets + (octave - 4) * bucketsPerOctave + step, numBuckets - 1);
+    }
+
+    // Largest value that lands in a bucket
+    static std::uint64_t getBucketTop(int bucket) noexcept {
+        if (bucket < numLinearBuckets)
+            return (std::uint64_t) bucket;
+        if (bucket == numBuckets - 1)
+            return UINT64_MAX;
+
+        const int octave = 4 + (bucket - numLinearBuckets) / bucketsPerOctave;
+        const auto step = (std::uint64_t) ((bucket - numLinearBuckets) % bucketsPerOctave);
+        return (((std::uint64_t) bucketsPerOctave + step + 1) << (octave - stepBits)) - 1;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, numBuckets> counts {};
+    std::atomic<std::uint64_t> maxValue { 0 };
+};
+
+// Per-instance cost of processBlock: the whole block, the part of it spent
+// designing coefficients (dynamic bands included), the part spent filtering,
+// the share of the block's realtime budget used and the number of bands in the
+// cascade. The audio thread records, anything else reads.
+//
+// Only built in with PARAMETRIC_EQ_PROFILING. Otherwise enabled is false, every
+// recording call is an empty inline function and nothing is timed.
+class DspProfiler {
+public:
+   #if PARAMETRIC_EQ_PROFILING
+    static constexpr bool enabled = true;
+   #else
+    static constexpr bool enabled = false;
+   #endif
+
+    using Ticks = juce::int64;
+
+    struct Statistics {
+        StatisticsHistogram::Summary blockMicroseconds, designMicroseconds, filterMicroseconds;
+        StatisticsHistogram::Summary loadPercent, activeBands;
+    };
+
+    DspProfiler() : nanosecondsPerTick(1.0e9 / (double) juce::Time::getHighResolutionTicksPerSecond()) {}
+
+    static Ticks now() noexcept {
+        if constexpr (enabled)
+            return juce::Time::getHighResolutionTicks();
+        else
+            return 0;
+    }
+
+    // Audio thread, in this order per block; addDesignTime() any number of times
+    void beginBlock() noexcept {
+        if constexpr (enabled) {
+            if (resetRequested.exchange(false, std::memory_order_relaxed))
+                for (auto* h : { &blockTime, &designTime, &filterTime, &load, &activeBands })
+                    h->clear();
+            designTicks = 0;
+            blockStart = now();
+        }
+    }
+
+    void beginFilters() noexcept {
+        if constexpr (enabled)
+            filterStart = now();
+    }
+
+    void addDesignTime(Ticks start) noexcept {
+        if constexpr (enabled)
+            designTicks += now() - start;
+        else
+            juce::ignoreUnused(start);
+    }
+
+    void endFilters() noexcept {
+        if constexpr (enabled)
+            filterTicks = now() - filterStart;
+    }
+
+    void endBlock(int numSamples, double sampleRate, int numActiveBands) noexcept {
+        if constexpr (enabled) {
+            const double blockNs = (double) (now() - blockStart) * nanosecondsPerTick;
+            blockTime.record((std::uint64_t) blockNs);
+            designTime.record((std::uint64_t) ((double) designTicks * nanosecondsPerTick));
+            filterTime.record((std::uint64_t) ((double) (filterTicks - designTicks) * nanosecondsPerTick));
+            activeBands.record((std::uint64_t) numActiveBands);
+
+            // Tenths of a percent, so a quiet instance still reads as more than 0
+            if (numSamples > 0 && sampleRate > 0)
+                load.record((std::uint64_t) (blockNs * sampleRate / (numSamples * 1.0e6)));
+        }
+        else {
+            juce::ignoreUnused(numSamples, sampleRate, numActiveBands);
+        }
+    }
+
+    // Any thread
+    Statistics getStatistics() const noexcept {
+        return { blockTime.summarise(1.0e-3), designTime.summarise(1.0e-3),
+                 filterTime.summarise(1.0e-3), load.summarise(0.1), activeBands.summarise() };
+    }
+
+    // Clears everything at the start of the next block
+    void reset() noexcept { resetRequested.store(true, std::memory_order_relaxed); }
+
+    // One line per measurement, for logs and the editor overlay
+    static juce::String toString(const Statistics& statistics);
+
+private:
+    const double nanosecondsPerTick;
+
+    StatisticsHistogram blockTime, designTime, filterTime, load, activeBands;
+    std::atomic<bool> resetRequested { false };
+
+    // Audio thread only
+    Ticks blockStart = 0, filterStart = 0, filterTicks = 0, designTicks = 0;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+#include "BiquadBank.h"
+
+// Threshold, ratio and timing of a dynamic band
+struct DynamicsSettings {
+    double thresholdDb = -20.0;
+    double ratio = 4.0;
+    double attackMs = 10.0;
+    double releaseMs = 100.0;
+};
+
+// Level detection for a dynamic band, run once per control interval. The
+// detector filter sees every channel at once in the SIMD lanes, like the
+// cascade, and the envelope only moves at the control rate: the sub-block's
+// mean square feeds an attack/release follower in dB, and the result becomes a
+// gain offset the band is redesigned with for that sub-block.
+template <typename FloatType>
+class DynamicsDetector {
+public:
+    using Vec = juce::dsp::SIMDRegister<FloatType>;
+
+    static constexpr double floorDb = -120.0;
+
+    void prepare(int numGroups) {
+        filter.prepare(numGroups);
+        reset();
+    }
+
+    void reset() {
+        filter.reset();
+        envelopeDb = floorDb;
+        peakMeanSquare = 0;
+    }
+
+    // The detector band: a band pass for a bell, a low or high pass for a shelf
+    void setFilter(const std::array<double,6>& c) {
+        filter.setCoefficients(c[0], c[1], c[2], c[3], c[4], c[5]);
+    }
+
+    // Filters one group of the current sub-block into scratch and keeps the
+    // largest per-channel mean square seen, so the band reacts to the loudest
+    // channel it is on (one bit per lane in lanes). Call for every group, then
+    // update().
+    void measure(const Vec* frames, Vec* scratch, int numSamples, int group,
+                 juce::uint32 lanes = ~juce::uint32(0)) noexcept {
+        std::copy(frames, frames + numSamples, scratch);
+        filter.process(scratch, numSamples, group);
+
+        auto sum = Vec::expand((FloatType) 0);
+        for (int n = 0; n < numSamples; ++n)
+            sum += scratch[n] * scratch[n];
+
+        for (size_t lane = 0; lane < Vec::SIMDNumElements; ++lane)
+            if ((lanes >> lane) & 1)
+                peakMeanSquare = std::max(peakMeanSquare, (double) sum.get(lane) / numSamples);
+    }
+
+    // Moves the envelope on by one sub-block of numSamples and returns the gain
+    // change for it in dB: zero below the threshold, and above it the cut that
+    // brings the level down by the ratio.
+    double update(const DynamicsSettings& settings, int numSamples, double sampleRate) {
+        const double levelDb = 10.0 * std::log10(std::max(peakMeanSquare, 1.0e-12));
+        peakMeanSquare = 0;
+
+        const double timeMs = levelDb > envelopeDb ? settings.attackMs : settings.releaseMs;
+        const double coefficient = std::exp(-1000.0 * numSamples / (std::max(timeMs, 0.01) * sampleRate));
+        envelopeDb = levelDb + (envelopeDb - levelDb) * coefficient;
+
+        const double overDb = envelopeDb - settings.thresholdDb;
+        return overDb > 0.0 ? -overDb * (1.0 - 1.0 / std::max(settings.ratio, 1.0)) : 0.0;
+    }
+
+    double getEnvelopeDb() const { return envelopeDb; }
+
+private:
+    BiquadBank<FloatType> filter;
+    double envelopeDb = floorDb;
+    double peakMeanSquare = 0;
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "LockFreeWakeup.h"
+
+// Linear-phase version of the EQ. The magnitude response of the biquad cascade is
+// sampled on an FFT grid, turned into a symmetric FIR and run through partitioned
+// FFT convolution. The FIR is designed on a background thread; the convolution
+// builds the new engine off the audio thread as well and crossfades into it.
+//
+// None of it exists while the mode is off: the convolutions, their loader
+// thread and the design thread are built when it's turned on, on the message
+// thread, and torn down again when it's turned off.
+class LinearPhaseEngine : private juce::Thread,
+                          private juce::AsyncUpdater {
+public:
+    // Returns the current { b0, b1, b2, a0, a1, a2 } of every band at the given
+    // sample rate. Called from the design thread and from wherever the engine is
+    // built, so it may only read atomics.
+    using BandDesigner = std::function<std::vector<std::array<double,6>>(double sampleRate)>;
+
+    explicit LinearPhaseEngine(BandDesigner designer);
+    ~LinearPhaseEngine() override;
+
+    // Builds the engine if it's enabled, designing the first kernel
+    // synchronously so the first block is already right
+    void prepare(double sampleRate, int maxBlockSize, int numChannels);
+    void release();
+    void reset() noexcept;
+
+    // Any thread: builds or tears the engine down on the message thread
+    void setEnabled(bool shouldBeEnabled);
+    // Does it now, for offline renders, which may have no message loop
+    void applyPendingChange();
+    // Audio thread: whether the engine is there to process()
+    bool isReady() const noexcept { return ready.load(std::memory_order_acquire); }
+
+    // Half the FIR: the delay every frequency goes through
+    int getLatencySamples() const { return firLength / 2; }
+
+    // Any thread, the audio thread included: wakes the design thread without
+    // locking
+    void requestUpdate() noexcept;
+
+    void process(float* const* channels, int numChannels, int numSamples) noexcept;
+
+    // Long enough to resolve a 30 Hz high pass: about 0.3 s, rounded up to a power of two
+    static int firLengthFor(double sampleRate);
+
+    // Zero-phase magnitude of the bands, windowed and centred on firLength / 2
+    static void designImpulseResponse(const std::vector<std::array<double,6>>& bands,
+                                      int firLength, juce::AudioBuffer<float>& ir);
+
+private:
+    using Convolutions = std::vector<std::unique_ptr<juce::dsp::Convolution>>;
+
+    void run() override;
+    void handleAsyncUpdate() override;
+    void build();
+    void tearDown();
+    void loadKernel(Convolutions& engines);
+
+    // Head partition of the non-uniform convolution; the tail uses larger blocks
+    static constexpr int headSize = 512;
+
+    BandDesigner designBands;
+    double sampleRate = 0;
+    int maxBlockSize = 0, numPreparedChannels = 0, firLength = 0;
+    std::atomic<bool> enabled { false }, ready { false }, dirty { false };
+    LockFreeWakeup wakeup;
+
+    // juce::dsp::Convolution handles at most two channels, so one per channel pair,
+    // all sharing one loader thread. Swapped in and out under engineLock, which
+    // the audio thread only ever tries; buildLock keeps building to one thread.
+    juce::CriticalSection buildLock;
+    juce::SpinLock engineLock;
+    std::unique_ptr<juce::dsp::ConvolutionMessageQueue> loaderQueue;
+    Convolutions convolutions;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LinearPhaseEngine)
+};
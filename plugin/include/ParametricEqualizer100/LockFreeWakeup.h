@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Wakes one sleeping thread from any other, the audio thread included. signal()
+// is an atomic increment and a notify on the counter's address (a futex, or
+// the platform's equivalent), where juce::WaitableEvent locks a mutex. A
+// signal that comes while the thread is still busy isn't lost: its next wait()
+// returns straight away.
+class LockFreeWakeup {
+public:
+    // Any thread
+    void signal() noexcept {
+        count.fetch_add(1, std::memory_order_release);
+        count.notify_one();
+    }
+
+    // The one waiting thread: sleeps until there was a signal since the last wait()
+    void wait() noexcept {
+        count.wait(seen, std::memory_order_acquire);
+        seen = count.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<std::uint32_t> count { 0 };
+    std::uint32_t seen = 0;
+};
@@ -1,7 +1,11 @@
 #pragma once
 
 // #include <JuceHeader.h>
+#include "BandComponent.h"
 #include "PluginProcessor.h"
+#include "ProfilerOverlay.h"
+#include "ResponseCurveComponent.h"
+#include "SpectrumComponent.h"
 
 //==============================================================================
 class AudioPluginAudioProcessorEditor  : public juce::AudioProcessorEditor
@@ -16,29 +20,33 @@ public:
 private:
     AudioPluginAudioProcessor& processorRef;
 
-    // High Pass
-    juce::Slider hpFreqSlider;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> hpFreqAttachment;
+    // EQ Curve, over the spectrum
+    SpectrumComponent spectrum;
+    ResponseCurveComponent responseCurve;
 
-    // Low Pass
-    juce::Slider lopFreqSlider;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> lopFreqAttachment;
+    // One strip of controls per band, scrolling sideways
+    juce::Viewport bandViewport;
+    juce::Component bandStrip;
+    std::vector<std::unique_ptr<BandComponent>> bandComponents;
 
-    // Bell 1
-    juce::Slider bell1FreqSlider, bell1GainSlider, bell1QSlider;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bell1FreqAttachment, bell1GainAttachment, bell1QAttachment;
+    // Linear Phase Toggle
+    juce::ToggleButton linearPhaseButton;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> linearPhaseAttachment;
 
-    // Bell 2
-    juce::Slider bell2FreqSlider, bell2GainSlider, bell2QSlider;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bell2FreqAttachment, bell2GainAttachment, bell2QAttachment;
+    // Oversampling
+    juce::ComboBox oversamplingBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
 
-    // Bell 3
-    juce::Slider bell3FreqSlider, bell3GainSlider, bell3QSlider;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> bell3FreqAttachment, bell3GainAttachment, bell3QAttachment;
+    // Stereo Mode
+    juce::ComboBox stereoBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> stereoAttachment;
 
-    // Shelf Mode Toggles
-    juce::ToggleButton isLowShelfModeButton, isHighShelfModeButton;
-    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> isLowShelfModeAttachment, isHighShelfModeAttachment;
+    // Filter Engine
+    juce::ComboBox engineBox;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> engineAttachment;
+
+    // processBlock statistics over the curve, in profiling builds only
+    std::unique_ptr<ProfilerOverlay> profilerOverlay;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginAudioProcessorEditor)
 };
@@ -1,40 +1,29 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
 #include <array>
-
-struct BiquadFilter {
-    double b0 = 1.0, b1 = 0.0, b2 = 0.0;
-    double a0 = 1.0, a1 = 0.0, a2 = 0.0;
-
-    // State:
-    double z1 = 0.0, z2 = 0.0;
-
-    void setCoefficients(
-            double b0_, double b1_, double b2_, 
-            double a0_, double a1_, double a2_
-            ) {
-        b0 = b0_; b1 = b1_; b2 = b2_;
-        a0 = a0_; a1 = a1_; a2 = a2_;
-    }
-
-    void reset() {
-        z1 = 0.0;
-        z2 = 0.0;
-    }
-
-    float processSample(float x) {
-        // Direct Form II implementation
-        double w = x - a1/a0*z1 - a2/a0*z2;
-        double y = b0/a0*w + b1/a0*z1 + b2/a0*z2;
-        z2 = z1;
-        z1 = w;
-        return (float) y;
-    }
-};
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "BatchDesigner.h"
+#include "BinaryState.h"
+#include "BiquadCascade.h"
+#include "BiquadFilter.h"
+#include "DspProfiler.h"
+#include "DynamicsDetector.h"
+#include "LinearPhaseEngine.h"
+#include "LockFreeWakeup.h"
+#include "PresetBank.h"
+#include "ResponseEvaluator.h"
+#include "SpectrumAnalyzer.h"
+#include "SvfCascade.h"
+#include "TripleBuffer.h"
 
 //=============================================================================
-class AudioPluginAudioProcessor final : public juce::AudioProcessor {
+class AudioPluginAudioProcessor final : public juce::AudioProcessor,
+                                        private juce::AudioProcessorValueTreeState::Listener {
 public:
     //=========================================================================
     AudioPluginAudioProcessor();
@@ -48,6 +37,13 @@ public:
     double getTailLengthSeconds() const override;
 
     //Program Handling
+    // Programs are the presets of a PresetBank, by default Presets.peqb in the
+    // user's application data folder under ParametricEqualizer100. Choosing one
+    // loads its state. Returns false, leaving no presets, if the file isn't a
+    // readable bank.
+    bool loadPresetBank(const juce::File& file);
+    static juce::File getDefaultPresetBankFile();
+
     int getNumPrograms() override;
     int getCurrentProgram() override;
     void setCurrentProgram (int index) override;
@@ -55,13 +51,16 @@ public:
     void changeProgramName (int index, const juce::String& newName) override;
 
     // Processing
-    using AudioProcessor::processBlock;
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
-    // State
+    // State, as a BinaryState blob. Loading applies every parameter and then
+    // jumps the filters straight to the result, designing each band once
+    // instead of smoothing toward it.
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
@@ -71,27 +70,407 @@ public:
 
     juce::AudioProcessorValueTreeState& getValueTreeState() { return apvts; }
 
-private:
+    // Parameter changes are smoothed and the coefficients redesigned once every
+    // control interval (in samples), interpolating in between. Takes effect on the
+    // next prepareToPlay.
+    void setControlInterval(int numSamples);
+    int getControlInterval() const { return controlInterval; }
 
-    // Parameter Layout
-    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    // Whether the design thread has a design of ours asked for or under way.
+    // Once false, the latest set is published for the next block to pick up.
+    bool isDesignPending() const noexcept { return designRequested.load() || designBusy.load(); }
+
+    // Magnitude and phase of the whole EQ as currently set, at numPoints
+    // log-spaced frequencies from 20 Hz to 20 kHz. Only bands whose parameters
+    // moved since the last call are designed and evaluated again. The phase is
+    // the cascade's; in linear-phase mode every frequency is just delayed
+    // instead. Message thread only.
+    const ResponseEvaluator::Curve& getFrequencyResponse(int numPoints);
+
+    // Pre/post spectrum, off until the editor enables it
+    SpectrumAnalyzer& getSpectrumAnalyzer() { return analyzer; }
 
-    // Filter calculation helper methods
+    // processBlock timings and band counts, when built with PARAMETRIC_EQ_PROFILING.
+    // Readable from any thread.
+    DspProfiler& getProfiler() { return profiler; }
+
+    // Bands, applied in order. Each has BAND<n>TYPE, BAND<n>ON, BAND<n>FREQ,
+    // BAND<n>GAIN and BAND<n>Q parameters, n counting from 1. Bands that are off
+    // (or at an identity setting) cost nothing in the cascade. Bells and shelves
+    // can also be dynamic: with BAND<n>DYN on, BAND<n>THRESH, RATIO, ATTACK and
+    // RELEASE turn the gain down as the band's own level rises. With STEREO set
+    // to Left/Right or Mid/Side, BAND<n>CHANNEL puts a band on both channels or
+    // on one of them (or of mid and side). Dynamics and the stereo modes apply to
+    // the cascade, not the linear-phase mode. High and low passes fall off at
+    // BAND<n>SLOPE, in a Butterworth or Linkwitz-Riley BAND<n>ALIGN. ENGINE runs
+    // the cascade as biquads or as state-variable sections.
+    static constexpr int maxBands = 24;
+    static juce::String getBandParameterID(int band, const char* suffix);
+
+    // A band runs as this many cascade sections at most: a bell or shelf takes
+    // one, a high or low pass one per second-order piece of its slope
+    static constexpr int maxSectionsPerBand = 8;
+
+    // The BAND<n>SLOPE choices, in dB/oct
+    static constexpr std::array<int, 8> passSlopes { 6, 12, 18, 24, 36, 48, 72, 96 };
+
+    // The sections a Butterworth or Linkwitz-Riley high or low pass of the given
+    // slope is built from, in the order they run: the Q of each second-order
+    // section, or 0 for a first-order one. Returns how many there are.
+    // Linkwitz-Riley is a Butterworth half the order run twice, so it needs a
+    // multiple of 12 dB/oct; 6 and 18 stay Butterworth.
+    static int getPassSectionQs(int slopeDbPerOctave, bool linkwitzRiley,
+                                std::array<double, maxSectionsPerBand>& qs);
+
+    // Filter calculation helper methods (RBJ cookbook), returning { b0, b1, b2, a0, a1, a2 }
     static std::array<double,6> makeLowPass(double sampleRate, double freq, double Q);
     static std::array<double,6> makeHighPass(double sampleRate, double freq, double Q);
+    static std::array<double,6> makeFirstOrderLowPass(double sampleRate, double freq);
+    static std::array<double,6> makeFirstOrderHighPass(double sampleRate, double freq);
+    static std::array<double,6> makeBandPass(double sampleRate, double freq, double Q);
     static std::array<double,6> makePeaking(double sampleRate, double freq, double Q, double dBgain);
     static std::array<double,6> makeLowShelf(double sampleRate, double freq, double Q, double dBgain);
     static std::array<double,6> makeHighShelf(double sampleRate, double freq, double Q, double dBgain);
 
-    // Our Filters
-    BiquadFilter highPassFilter;
-    BiquadFilter bell1Filter;
-    BiquadFilter bell2Filter;
-    BiquadFilter bell3Filter;
-    BiquadFilter lowPassFilter;
+    // Any of the above as a state-variable section, with the same response: one
+    // tan for the frequency and a few multiplies for the rest. This is what the
+    // ENGINE parameter's State Variable setting runs.
+    static SvfCoefficients<double> makeSvf(FilterType type, double sampleRate,
+                                           double freq, double Q, double dBgain = 0.0);
+
+private:
+
+    // Parameter Layout
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    // The BAND<n>TYPE choices, in order
+    static constexpr std::array<FilterType, 5> bandTypes {
+        FilterType::peaking, FilterType::lowShelf, FilterType::highShelf,
+        FilterType::highPass, FilterType::lowPass };
+
+    // Parameter values are read through these, looked up once in the constructor
+    struct BandParameters {
+        std::atomic<float>* type = nullptr;
+        std::atomic<float>* enabled = nullptr;
+        std::atomic<float>* freq = nullptr;
+        std::atomic<float>* gain = nullptr;
+        std::atomic<float>* q = nullptr;
+        std::atomic<float>* dynamic = nullptr;
+        std::atomic<float>* threshold = nullptr;
+        std::atomic<float>* ratio = nullptr;
+        std::atomic<float>* attack = nullptr;
+        std::atomic<float>* release = nullptr;
+        std::atomic<float>* channel = nullptr;
+        std::atomic<float>* slope = nullptr;
+        std::atomic<float>* alignment = nullptr;
+    };
+    static constexpr std::array<const char*, 13> bandParameterSuffixes {
+        "TYPE", "ON", "FREQ", "GAIN", "Q", "DYN", "THRESH", "RATIO", "ATTACK", "RELEASE", "CHANNEL",
+        "SLOPE", "ALIGN" };
+
+    // Where a band's smoothed frequency, gain and Q currently are
+    struct BandSettings {
+        double freq = 0, gain = 0, q = 0.707;
+    };
+
+    // What a band that is off designs to
+    static constexpr std::array<double,6> bypassedBand { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+
+    // A band's coefficients, one set per cascade section it runs as, for each
+    // engine. A band that is off has none.
+    struct BandDesign {
+        std::array<std::array<double,6>, maxSectionsPerBand> sections {};
+        std::array<SvfCoefficients<double>, maxSectionsPerBand> svfSections {};
+        int numSections = 0;
+
+        bool operator==(const BandDesign&) const = default;
+    };
+
+    // The filter type and Q of each of a band's sections
+    struct Section {
+        FilterType type = FilterType::peaking;
+        double q = 0.707;
+    };
+    using BandSections = std::array<Section, maxSectionsPerBand>;
+
+    // Ramps a band's frequency, gain and Q toward the current parameter values
+    struct BandSmoother {
+        juce::SmoothedValue<float> freq, gain, q;
+
+        void reset(double sampleRate, double rampSeconds) {
+            for (auto* v : { &freq, &gain, &q })
+                v->reset(sampleRate, rampSeconds);
+        }
+
+        bool isSmoothing() const {
+            return freq.isSmoothing() || gain.isSmoothing() || q.isSmoothing();
+        }
+
+        void skip(int numSamples) {
+            for (auto* v : { &freq, &gain, &q })
+                v->skip(numSamples);
+        }
+    };
+
+    static constexpr double smoothingTimeSeconds = 0.05;
+    static constexpr int defaultControlInterval = 32;
+
+    // Coefficient cache: a band is only redesigned when one of its inputs moved
+    // or while it is still ramping toward them
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void updateSmootherTargets(int band, bool jump);
+    void updateBandCoefficients(int band, double sampleRate, int rampLength);
+    BandDesign designBand(int band, double sampleRate, double freq, double gain, double Q) const;
+    static std::array<double,6> makeSection(FilterType type, double sampleRate,
+                                            double freq, double Q, double gain);
+
+    // The sections a band is made of, none when it is off. At 12 dB/oct
+    // Butterworth a pass band is the one section it always was, at the band's Q;
+    // other slopes and alignments have Qs of their own.
+    int getBandSections(int band, double Q, BandSections& sections) const;
+
+    // Smoothed bands are designed together: queueSmoothedBand() adds the sections
+    // of a band at its current smoother values to batchDesigner, and says where
+    // they are there for getDesignedBand() to pick up after design()
+    struct QueuedBand {
+        int band = 0, first = 0, numSections = 0;
+    };
+    FilterType getBandType(int band) const;
+    bool isBandEnabled(int band) const { return *bandParameters[(size_t) band].enabled > 0.5f; }
+    QueuedBand queueSmoothedBand(int band, double sampleRate);
+    BandDesign getDesignedBand(const QueuedBand& queued) const;
+
+    // Dynamic bands are designed on the audio thread every control interval,
+    // from their smoothed settings plus the detector's gain change
+    bool isBandDynamic(int band) const;
+    DynamicsSettings getDynamicsSettings(int band) const;
+    BandSettings getCurrentBandSettings(int band) const;
+    void processDynamics(double sampleRate, int blockSize);
+
+    // The unsmoothed target of a band, or the sections of every band in cascade
+    // order for the linear-phase designer and the tail
+    BandDesign designTargetBand(int band, double sampleRate) const;
+    std::vector<std::array<double,6>> designTargetBands(double sampleRate) const;
+    bool isLinearPhase() const { return *linearPhaseParam > 0.5f; }
+
+    // Both processBlock()s: float and double share all of it
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+
+    // Linear phase, or the cascade with or without oversampling
+    template <typename SampleType>
+    void processFilters(SampleType* const* channels, int numChannels, int numSamples);
+    void processOversampled(float* const* channels, int numChannels, int numSamples);
+
+    // Runs the cascade over the channels at the current (oversampled) rate
+    template <typename SampleType>
+    void processCascade(SampleType* const* channels, int numChannels, int numSamples);
+
+    // Sections the cascade is currently running (a steep pass band counts as
+    // several), or bands on in linear phase, for the profiler
+    int countActiveBands() const;
+
+    // Silence handling. The tail is how long the filters ring after the input
+    // stops, until they're tailDecayDb down: reported to the host from the band
+    // settings, and used on the audio thread, from the running filters, to send
+    // them idle once the input has been silent that long.
+    static constexpr double tailDecayDb = -120.0;
+    static constexpr double tailMarginSamples = 64.0;
+    static constexpr double maxTailSeconds = 30.0;
+    double computeTailSamples(double cascadeDecaySamples, bool linear, int order) const;
+    double getRunningTailSamples();
+    void enterIdle();
+    void skipIdleSmoothing(int numSamples);
+
+    // Switches the cascade to 2^order times the host rate. Offline every band is
+    // redesigned into the engine that's running; in realtime the design thread
+    // is asked for them. Allocation free, so it can happen on the audio thread.
+    void setOversamplingOrder(int order);
+    int getOversamplingParamOrder() const { return juce::roundToInt(oversamplingParam->load()); }
+    int computeLatencySamples(bool linear, int order) const;
+
+    // Coefficient design off the audio thread. While playing in realtime the
+    // smoothers live on a design thread, which publishes complete sets for all
+    // bands through a triple buffer; the audio thread picks up the latest one at
+    // a sub-block boundary and ramps to it. The smoothers move on by the samples
+    // the audio thread has played, not by the time that passed, so a ramp takes
+    // as many samples as it does offline. Rendering offline designs inline, at
+    // every sub-block, as before.
+    using BandCoefficients = std::array<BandDesign, maxBands>;
+
+    // changedBands has a bit for every band redesigned since the last set the
+    // audio thread picked up, which are the only ones it looks at
+    struct CoefficientSet {
+        BandCoefficients bands {};
+        std::array<BandSettings, maxBands> settings {};
+        juce::uint32 changedBands = 0;
+        double sampleRate = 0;
+    };
+
+    // One design thread serves every instance in the process, and sleeps until
+    // one of them asks for a design: when a parameter moves, a state is loaded or
+    // the rate changes, and after each block played while a band is smoothing.
+    // Asking never locks, so the audio thread can do it.
+    class DesignThread final : public juce::Thread {
+    public:
+        DesignThread();
+        ~DesignThread() override;
+        void add(AudioPluginAudioProcessor& processor);
+        void remove(AudioPluginAudioProcessor& processor);
+        void wake() noexcept { work.signal(); }
+        void run() override;
+    private:
+        juce::CriticalSection lock;
+        juce::SortedSet<AudioPluginAudioProcessor*> processors;
+        LockFreeWakeup work;
+    };
+
+    // Any thread, the audio thread included: has the design thread run
+    // designCoefficients() for us soon
+    void requestDesign() noexcept;
+    // Design thread
+    void designCoefficients();
+    // Audio thread
+    void applyDesignedCoefficients(double sampleRate, int rampLength);
+
+    // Precision the filters run in. Float doubles the SIMD lanes but has less
+    // headroom for low-frequency, high-Q bands.
+   #if PARAMETRIC_EQ_SINGLE_PRECISION_FILTERS
+    using FilterStateType = float;
+   #else
+    using FilterStateType = double;
+   #endif
+
+    // Our Filters: maxSectionsPerBand cascade sections per band, band after band,
+    // every channel in its own SIMD lane. Only the sections a band needs are set.
+    ChannelLanes<FilterStateType> channelLanes;
+    BiquadCascade<FilterStateType> cascade;
+    using LaneMask = BiquadCascade<FilterStateType>::LaneMask;
+    std::array<int, maxBands> sectionsInUse {};   // audio thread
+
+    // The ENGINE parameter: the bands as biquads or as state-variable sections,
+    // which stay stable when their settings move every sample. Every design
+    // carries both, so a switch only has to move the bands across; it starts the
+    // new engine from silence.
+    enum class FilterEngine { biquad, stateVariable };
+    FilterEngine getFilterEngine() const;
+    void switchFilterEngine(FilterEngine engine);
+    SvfCascade<FilterStateType> svfCascade;
+    FilterEngine activeEngine = FilterEngine::biquad;   // audio thread
+    double getCascadeDecaySamples() const;
+
+    // Ramps a band's sections to a design over rampLength samples, or jumps when
+    // rampLength is 0. Sections the band used before and no longer needs go
+    // back to identity.
+    void setBandSections(int band, const BandDesign& design, int rampLength, LaneMask lanes);
+
+    // Stereo modes. Linked runs every band on every channel. For a stereo pair,
+    // Left/Right and Mid/Side put each band on the channel or component its
+    // BAND<n>CHANNEL says, as lanes of the one cascade pass; Mid/Side is encoded
+    // and decoded as the block goes in and out of the lanes.
+    enum class StereoMode { linked, leftRight, midSide };
+    StereoMode getStereoMode() const;
+    LaneMask getBandLanes(int band) const;
+    bool midSideActive = false;
+    std::array<LaneMask, maxBands> appliedLanes {};   // audio thread, threaded design
+
+    // One level detector per band, used while the band is dynamic
+    std::array<DynamicsDetector<FilterStateType>, maxBands> detectors;
+    std::array<bool, maxBands> detectorActive {};
+    std::vector<typename ChannelLanes<FilterStateType>::Vec> detectorScratch;
+    BatchDesigner dynamicsDesigner;
+
+    // Linear-phase alternative to the cascade, adding getLatencySamples() of delay.
+    // Only built while LINEARPHASE is on.
+    LinearPhaseEngine linearPhase;
+    bool linearPhaseActive = false;
+
+    // Samples of all-zero input since the last sound, and whether the filters
+    // have been put to sleep because of it
+    juce::int64 silentSamples = 0;
+    bool idle = false;
+
+    // The running tail as of the last coefficient change, so silent blocks don't
+    // go through every section's poles again
+    double runningTailSamples = 0;
+    bool runningTailDirty = true;
+
+    // Polyphase IIR half-band oversampling around the cascade, so bells and
+    // shelves near Nyquist aren't cramped by the bilinear transform. One
+    // oversampler per order (2x, 4x), all prepared up front.
+    static constexpr int maxOversamplingOrder = 2;
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, maxOversamplingOrder> oversamplers;
+    std::vector<float*> oversampledChannels;
+    int oversamplingOrder = 0;
+
+    // Double-precision blocks are copied here for the paths that only take float
+    juce::AudioBuffer<float> floatBuffer;
+
+    // Cached response for the editor, touched on the message thread only, and
+    // the bands that moved since it was last updated
+    ResponseEvaluator responseEvaluator;
+    std::array<std::atomic<bool>, maxBands> responseDirty;
+
+    SpectrumAnalyzer analyzer;
+    DspProfiler profiler;
+
+    // Programs. The default bank is mapped once for every instance in the
+    // process, and only when a program is first asked for; a bank passed to
+    // loadPresetBank() is this instance's own. Message thread only.
+    class DefaultPresetBank {
+    public:
+        const PresetBank& get();
+    private:
+        juce::CriticalSection lock;
+        PresetBank bank;
+        bool opened = false;
+    };
+    const PresetBank& getPresetBank();
+    juce::SharedResourcePointer<DefaultPresetBank> defaultPresetBank;
+    std::unique_ptr<PresetBank> loadedPresetBank;
+    int currentProgram = 0;
 
     // Parameter State
     juce::AudioProcessorValueTreeState apvts;
+    std::array<BandParameters, maxBands> bandParameters;
+    std::array<std::atomic<bool>, maxBands> bandDirty;
+    std::array<BandSmoother, maxBands> smoothers;
+    std::atomic<float>* linearPhaseParam = nullptr;
+    std::atomic<float>* oversamplingParam = nullptr;
+    std::atomic<float>* stereoParam = nullptr;
+    std::atomic<float>* engineParam = nullptr;
+    int controlInterval = defaultControlInterval;
+
+    // State Serialisation: every parameter with its ID hash, in getParameters()
+    // order, and the same sorted by hash for states written in another order
+    struct StateSlot {
+        juce::uint32 idHash;
+        juce::RangedAudioParameter* parameter;
+    };
+    std::vector<StateSlot> stateSlots, stateSlotsByHash;
+    std::vector<BinaryState::Entry> stateEntries;
+    std::atomic<bool> snapToTargets { false };
+    std::atomic<bool> loadingState { false };
+
+    // Coefficient Handoff
+    bool threadedDesign = false;
+    TripleBuffer<CoefficientSet> coefficientSets;
+    std::atomic<double> designSampleRate { 0.0 };
+    BatchDesigner batchDesigner;            // design thread, or audio thread offline
+    BandCoefficients appliedBands {};       // audio thread
+    std::array<BandSettings, maxBands> appliedSettings {};
+    BandCoefficients designedBands {};      // design thread
+    std::array<BandSettings, maxBands> designedSettings {};
+    juce::uint32 publishedChangedBands = 0;
+    std::atomic<juce::int64> samplesPlayed { 0 };   // by the audio thread, at the cascade's rate
+    double designerSampleRate = 0;
+    juce::int64 designedSamples = 0;                 // samplesPlayed at the last design
+    std::atomic<bool> designRequested { false };
+    std::atomic<bool> designSmoothing { false };   // a band was still smoothing at the last design
+    // Set by the design thread, under its lock, while it's designing us: all
+    // DesignThread::remove() has to wait for
+    std::atomic<bool> designBusy { false };
+    juce::SharedResourcePointer<DesignThread> designThread;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginAudioProcessor)
 };
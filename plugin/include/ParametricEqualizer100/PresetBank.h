@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <vector>
+
+// A file of named presets, each stored as a BinaryState blob. The file starts
+// with a fixed-size index (name and state offsets per preset), so opening it
+// only maps it into memory and checks the index: listing names and loading a
+// preset read straight out of the mapping without touching the others.
+//
+//   header   magic "PEQB", version, preset count             12 bytes
+//   index    name offset, name length, state offset, size    16 bytes per preset
+//   data     UTF-8 names and state blobs
+class PresetBank {
+public:
+    struct Preset {
+        juce::String name;
+        juce::MemoryBlock state;
+    };
+
+    static constexpr juce::uint32 magic = 0x42514550;    // "PEQB"
+    static constexpr juce::uint32 currentVersion = 1;
+
+    static bool write(const juce::File& file, const std::vector<Preset>& presets);
+
+    // Returns false, leaving the bank empty, if the file isn't a readable bank
+    bool open(const juce::File& file);
+    void close();
+
+    int getNumPresets() const { return numPresets; }
+    juce::String getPresetName(int index) const;
+
+    // The preset's state, ready for setStateInformation(); valid until close()
+    const void* getPresetState(int index, size_t& size) const;
+
+private:
+    static constexpr size_t headerSize = 12;
+    static constexpr size_t indexEntrySize = 16;
+
+    juce::uint32 readIndex(int index, int field) const;
+
+    std::unique_ptr<juce::MemoryMappedFile> mapping;
+    const char* data = nullptr;
+    int numPresets = 0;
+};
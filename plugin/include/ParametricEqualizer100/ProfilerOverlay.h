@@ -0,0 +1,31 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "DspProfiler.h"
+
+//==============================================================================
+// The profiler's histograms as text, refreshed a few times a second. Only
+// shown by the editor when profiling is built in. Clicking it starts the
+// statistics over.
+class ProfilerOverlay final : public juce::Component,
+                              private juce::Timer {
+public:
+    explicit ProfilerOverlay(DspProfiler&);
+    ~ProfilerOverlay() override;
+
+    void paint(juce::Graphics&) override;
+    void mouseDown(const juce::MouseEvent&) override;
+
+    static constexpr int preferredWidth = 300;
+    static constexpr int preferredHeight = 84;
+
+private:
+    void timerCallback() override;
+
+    static constexpr int refreshRateHz = 4;
+
+    DspProfiler& profiler;
+    juce::StringArray lines;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProfilerOverlay)
+};
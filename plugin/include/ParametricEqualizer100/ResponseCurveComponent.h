@@ -0,0 +1,32 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+
+class AudioPluginAudioProcessor;
+
+//==============================================================================
+// The EQ curve: magnitude over 20 Hz - 20 kHz on a log axis. Polls the
+// processor's cached response on a timer and only rebuilds the path when the
+// response actually changed.
+class ResponseCurveComponent final : public juce::Component,
+                                     private juce::Timer {
+public:
+    explicit ResponseCurveComponent(AudioPluginAudioProcessor&);
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    void rebuildPath();
+
+    static constexpr float rangeDb = 24.0f;
+    static constexpr int refreshRateHz = 30;
+
+    AudioPluginAudioProcessor& processorRef;
+    juce::Path magnitudePath;
+    int drawnVersion = -1;
+    int drawnWidth = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseCurveComponent)
+};
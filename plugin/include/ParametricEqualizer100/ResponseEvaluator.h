@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+// Frequency response of a cascade of biquads on a log-spaced grid, cached per
+// band. cos/sin of w and 2w are tabulated once per grid as separate arrays, so
+// evaluating a section is a few straight, branch-free loops the compiler can
+// vectorise, and only bands whose sections changed are evaluated again. A band
+// may be several sections, or none when it is off; the cache is keyed on the
+// band, so a band changing its number of sections leaves the others alone.
+class ResponseEvaluator {
+public:
+    struct Curve {
+        std::vector<float> frequencies;
+        std::vector<float> magnitudeDb;
+        std::vector<float> phaseRadians;   // wrapped to [-pi, pi]
+        int version = 0;                   // bumped whenever the curve changes
+    };
+
+    // Rebuilds the grid (and so every band) only when something differs.
+    // Returns true if it did.
+    bool setGrid(int numPoints, double sampleRate,
+                 double minFrequency = 20.0, double maxFrequency = 20000.0);
+
+    // Sets a band's { b0, b1, b2, a0, a1, a2 } sections, in cascade order. It is
+    // evaluated again by the next update() if they differ from the last ones.
+    void setNumBands(int numBands);
+    void setBand(int band, const std::array<double,6>* sections, int numSections);
+
+    // Sums the bands into the curve if any changed. Returns true if it did.
+    bool update();
+
+    // The same with every band a single section, in cascade order
+    bool update(const std::vector<std::array<double,6>>& bands);
+
+    const Curve& getCurve() const { return curve; }
+    int getNumPoints() const { return (int) curve.frequencies.size(); }
+
+private:
+    struct Band {
+        std::vector<std::array<double,6>> sections;
+        bool valid = false;
+        std::vector<float> magnitudeDb, phaseRadians;
+    };
+
+    void evaluateBand(Band& band) const;
+    void addSection(Band& band, const std::array<double,6>& c) const;
+    void sumBands();
+
+    double sampleRate = 0, minFrequency = 0, maxFrequency = 0;
+    std::vector<double> cosw, sinw, cos2w, sin2w;
+    std::vector<Band> bands;
+    Curve curve;
+};
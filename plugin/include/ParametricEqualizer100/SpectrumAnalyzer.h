@@ -0,0 +1,86 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+// Pre/post EQ spectrum for the editor. The audio thread only mixes each tap down
+// to mono into a lock-free single-producer/single-consumer FIFO; a background
+// thread drains it, runs Hann-windowed FFTs with 75% overlap, averages and
+// peak-holds the bins and publishes frames for the editor to copy.
+// Disabled (the default), push() is a single atomic load and the thread isn't
+// running at all.
+class SpectrumAnalyzer : private juce::Thread {
+public:
+    enum Tap { preTap, postTap, numTaps };
+
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2;
+    static constexpr float floorDb = -120.0f;
+
+    // One published spectrum, bins spaced sampleRate / fftSize apart
+    struct Frame {
+        std::vector<float> averageDb, peakDb;
+        double sampleRate = 0;
+        int version = 0;
+    };
+
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer() override;
+
+    // Not while the audio thread is pushing
+    void prepare(double sampleRate);
+
+    // Message thread: the editor turns the analyzer on while it is open
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    // Audio thread: never blocks or allocates. Drops samples if the FIFO is full.
+    void push(Tap tap, const float* const* channels, int numChannels, int numSamples) noexcept;
+    void push(Tap tap, const double* const* channels, int numChannels, int numSamples) noexcept;
+
+    // Copies the latest frame of a tap into frame, unless frame is already that
+    // version. Returns true if it copied. Not for the audio thread.
+    bool getFrame(Tap tap, Frame& frame) const;
+
+private:
+    template <typename SampleType>
+    void pushSamples(Tap tap, const SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    void run() override;
+    void drain(int tap);
+    void analyseFrame(int tap);
+
+    static constexpr int hopSize = fftSize / 4;
+    static constexpr int fifoSize = 1 << 15;
+    static constexpr int displayRateHz = 30;
+    static constexpr float averagingCoefficient = 0.25f;
+    static constexpr float peakDecayDb = 0.5f;
+
+    struct TapState {
+        juce::AbstractFifo fifo { fifoSize };
+        std::vector<float> fifoData = std::vector<float>((size_t) fifoSize);
+
+        // Background thread only
+        std::vector<float> history = std::vector<float>((size_t) fftSize);
+        std::vector<float> averageDb = std::vector<float>((size_t) numBins, floorDb);
+        std::vector<float> peakDb = std::vector<float>((size_t) numBins, floorDb);
+
+        // Guarded by frameLock
+        Frame published;
+    };
+
+    std::array<TapState, numTaps> taps;
+    juce::dsp::FFT fft { fftOrder };
+    std::vector<float> window = std::vector<float>((size_t) fftSize);
+    std::vector<float> fftData = std::vector<float>((size_t) (2 * fftSize));
+    float windowGain = 1.0f;
+    double sampleRate = 0;
+    std::atomic<bool> enabled { false };
+    juce::CriticalSection frameLock;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzer)
+};
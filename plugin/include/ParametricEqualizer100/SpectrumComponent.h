@@ -0,0 +1,33 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "SpectrumAnalyzer.h"
+
+//==============================================================================
+// Pre and post EQ spectrum on the same 20 Hz - 20 kHz log axis as the curve.
+// Switches the analyzer on for as long as it exists, so a closed editor costs
+// the audio thread nothing.
+class SpectrumComponent final : public juce::Component,
+                                private juce::Timer {
+public:
+    explicit SpectrumComponent(SpectrumAnalyzer&);
+    ~SpectrumComponent() override;
+
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    juce::Path makePath(const std::vector<float>& db, double sampleRate, bool closed) const;
+    void rebuildPaths();
+
+    static constexpr float minDb = -90.0f;
+    static constexpr float maxDb = 0.0f;
+    static constexpr int refreshRateHz = 30;
+
+    SpectrumAnalyzer& analyzer;
+    SpectrumAnalyzer::Frame preFrame, postFrame;
+    juce::Path prePath, postPath, peakPath;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumComponent)
+};
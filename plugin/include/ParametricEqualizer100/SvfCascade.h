@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <juce_dsp/juce_dsp.h>
+#include "SvfFilter.h"
+
+// The state-variable counterpart of BiquadCascade: the same chain of sections,
+// structure-of-arrays layout, per-lane coefficients and skipping of identity
+// sections, with a trapezoidal SVF in each section instead of a TDF-II biquad.
+//
+// Where the two differ is ramping. BiquadCascade interpolates the biquad
+// coefficients, and the filters in between aren't the ones either end was
+// designed as, nor always stable. Here g, k and the output mix are
+// interpolated, and a1..a3 worked out from them again every sample: each sample
+// runs a properly tuned filter on the way to the target, however far the
+// settings move in one ramp.
+template <typename FloatType>
+class SvfCascade {
+public:
+    using Vec = juce::dsp::SIMDRegister<FloatType>;
+
+    // One bit per lane of a group: the lanes a section filters
+    using LaneMask = juce::uint32;
+    static constexpr LaneMask allLanes = ~LaneMask(0);
+    static constexpr int numLanes = (int) Vec::SIMDNumElements;
+
+    void prepare(int numSectionsToUse, int numGroupsToUse) {
+        numSections = numSectionsToUse;
+        numGroups = numGroupsToUse;
+
+        const auto n = (size_t) numSections;
+        const auto identity = expand(SvfCoefficients<double>::identity());
+        for (auto* c : { &current, &target, &step })
+            c->assign(n, identity);
+        taps.assign(n, getTaps(identity));
+        ramping.assign(n, false);
+        neutral.assign(n, true);
+        targetNeutral.assign(n, true);
+
+        ic1.assign(n * (size_t) numGroups, Vec::expand((FloatType) 0));
+        ic2.assign(n * (size_t) numGroups, Vec::expand((FloatType) 0));
+
+        active.assign(n, false);
+        activeSections.clear();
+        activeSections.reserve(n);
+        numActive = 0;
+        activeChanged = false;
+    }
+
+    void reset() {
+        std::fill(ic1.begin(), ic1.end(), Vec::expand((FloatType) 0));
+        std::fill(ic2.begin(), ic2.end(), Vec::expand((FloatType) 0));
+    }
+
+    int getNumSections() const { return numSections; }
+    int getNumActiveSections() const { return numActive; }
+
+    // As BiquadCascade::getDecaySamples(), from each section's biquad equivalent
+    double getDecaySamples(double decayDb) const {
+        double samples = 0;
+        for (size_t i = 0; i < (size_t) numSections; ++i) {
+            if (! active[i])
+                continue;
+            double decay = 0;
+            for (int lane = 0; lane < numLanes; ++lane) {
+                decay = std::max(decay, getLane(current, i, lane).toBiquad().getDecaySamples(decayDb));
+                if (ramping[i])
+                    decay = std::max(decay, getLane(target, i, lane).toBiquad().getDecaySamples(decayDb));
+            }
+            samples += decay;
+        }
+        return samples;
+    }
+
+    // Jumps straight to a new section, in the given lanes.
+    void setCoefficients(int section, const SvfCoefficients<double>& c, LaneMask lanes = allLanes) {
+        const auto i = (size_t) section;
+        current.set(i, expand(c, lanes));
+        target.set(i, current.get(i));
+        taps[i] = getTaps(current.get(i));
+        neutral[i] = targetNeutral[i] = isNeutral(c, lanes);
+        ramping[i] = false;
+        updateActive(i);
+    }
+
+    // Moves linearly to a new section over the next rampLength samples, with the
+    // same contract as BiquadCascade::setTargetCoefficients(): every group is
+    // processed with exactly rampLength samples, then commitRamps().
+    void setTargetCoefficients(int section, const SvfCoefficients<double>& c, int rampLength,
+                               LaneMask lanes = allLanes) {
+        const auto i = (size_t) section;
+        target.set(i, expand(c, lanes));
+        targetNeutral[i] = isNeutral(c, lanes);
+
+        // Moving between two identity filters is inaudible, so there is nothing to ramp
+        if (neutral[i] && targetNeutral[i]) {
+            current.set(i, target.get(i));
+            taps[i] = getTaps(current.get(i));
+            ramping[i] = false;
+            updateActive(i);
+            return;
+        }
+
+        const auto inv = Vec::expand((FloatType) 1 / (FloatType) rampLength);
+        step.g[i] = (target.g[i] - current.g[i]) * inv;
+        step.k[i] = (target.k[i] - current.k[i]) * inv;
+        step.m0[i] = (target.m0[i] - current.m0[i]) * inv;
+        step.m1[i] = (target.m1[i] - current.m1[i]) * inv;
+        step.m2[i] = (target.m2[i] - current.m2[i]) * inv;
+        ramping[i] = true;
+        updateActive(i);
+    }
+
+    void commitRamps() {
+        for (size_t i = 0; i < (size_t) numSections; ++i) {
+            if (ramping[i]) {
+                current.set(i, target.get(i));
+                taps[i] = getTaps(current.get(i));
+                neutral[i] = targetNeutral[i];
+                ramping[i] = false;
+                updateActive(i);
+            }
+        }
+    }
+
+    void process(Vec* frames, int numSamples, int group) noexcept {
+        if (activeChanged)
+            rebuildActiveSections();
+
+        Vec* groupIc1 = ic1.data() + group * numSections;
+        Vec* groupIc2 = ic2.data() + group * numSections;
+
+        for (size_t k = 0; k < activeSections.size(); ++k) {
+            const auto i = (size_t) activeSections[k];
+
+            // Two settled sections share a sample loop, as in BiquadCascade
+            const bool paired = k + 1 < activeSections.size()
+                            && ! ramping[i] && ! ramping[(size_t) activeSections[k + 1]];
+            if (paired) {
+                const auto j = (size_t) activeSections[++k];
+                Vec z1a = groupIc1[i], z2a = groupIc2[i], z1b = groupIc1[j], z2b = groupIc2[j];
+                const auto ta = taps[i], tb = taps[j];
+                for (int n = 0; n < numSamples; ++n) {
+                    const Vec y = processSvfTPT(frames[n], ta, z1a, z2a);
+                    frames[n] = processSvfTPT(y, tb, z1b, z2b);
+                }
+
+                groupIc1[i] = z1a; groupIc2[i] = z2a;
+                groupIc1[j] = z1b; groupIc2[j] = z2b;
+                continue;
+            }
+
+            Vec z1 = groupIc1[i], z2 = groupIc2[i];
+
+            if (ramping[i]) {
+                auto c = current.get(i);
+                const auto d = step.get(i);
+                for (int n = 0; n < numSamples; ++n) {
+                    c.g += d.g; c.k += d.k;
+                    c.m0 += d.m0; c.m1 += d.m1; c.m2 += d.m2;
+                    frames[n] = processSvfTPT(frames[n], getTaps(c), z1, z2);
+                }
+            }
+            else {
+                const auto t = taps[i];
+                for (int n = 0; n < numSamples; ++n)
+                    frames[n] = processSvfTPT(frames[n], t, z1, z2);
+            }
+
+            groupIc1[i] = z1;
+            groupIc2[i] = z2;
+        }
+    }
+
+private:
+    // One array per parameter, indexed by section
+    struct ParameterArrays {
+        std::vector<Vec> g, k, m0, m1, m2;
+
+        void assign(size_t n, const SvfCoefficients<Vec>& c) {
+            g.assign(n, c.g); k.assign(n, c.k);
+            m0.assign(n, c.m0); m1.assign(n, c.m1); m2.assign(n, c.m2);
+        }
+
+        SvfCoefficients<Vec> get(size_t i) const {
+            return { g[i], k[i], m0[i], m1[i], m2[i] };
+        }
+
+        void set(size_t i, const SvfCoefficients<Vec>& c) {
+            g[i] = c.g; k[i] = c.k;
+            m0[i] = c.m0; m1[i] = c.m1; m2[i] = c.m2;
+        }
+    };
+
+    static constexpr double identityTolerance = 1.0e-12;
+
+    static constexpr LaneMask laneBits = (LaneMask(1) << numLanes) - 1;
+
+    // SIMDRegister has no division, so the one reciprocal goes lane by lane
+    static SvfTaps<Vec> getTaps(const SvfCoefficients<Vec>& c) noexcept {
+        Vec a1 = Vec::expand((FloatType) 1) + c.g * (c.g + c.k);
+        for (size_t lane = 0; lane < (size_t) numLanes; ++lane)
+            a1.set(lane, (FloatType) 1 / a1.get(lane));
+        const Vec a2 = c.g * a1;
+        return { a1, a2, c.g * a2, c.m0, c.m1, c.m2 };
+    }
+
+    // c in the given lanes, identity in the rest
+    static SvfCoefficients<Vec> expand(const SvfCoefficients<double>& c, LaneMask lanes = allLanes) {
+        const auto identity = SvfCoefficients<double>::identity();
+        SvfCoefficients<Vec> v;
+        const auto fill = [lanes](Vec& dest, double value, double identityValue) {
+            for (int lane = 0; lane < numLanes; ++lane)
+                dest.set((size_t) lane, (FloatType) (((lanes >> lane) & 1) ? value : identityValue));
+        };
+        fill(v.g, c.g, identity.g);
+        fill(v.k, c.k, identity.k);
+        fill(v.m0, c.m0, identity.m0);
+        fill(v.m1, c.m1, identity.m1);
+        fill(v.m2, c.m2, identity.m2);
+        return v;
+    }
+
+    static bool isNeutral(const SvfCoefficients<double>& c, LaneMask lanes) {
+        return (lanes & laneBits) == 0 || c.toBiquad().isIdentity(identityTolerance);
+    }
+
+    static SvfCoefficients<double> getLane(const ParameterArrays& c, size_t i, int lane) {
+        const auto l = (size_t) lane;
+        return { (double) c.g[i].get(l), (double) c.k[i].get(l), (double) c.m0[i].get(l),
+                 (double) c.m1[i].get(l), (double) c.m2[i].get(l) };
+    }
+
+    void updateActive(size_t i) {
+        const bool isActive = ! neutral[i] || ramping[i];
+        if (active[i] == isActive)
+            return;
+
+        // A section dropping out takes its leftover state with it, so it comes
+        // back from silence instead of replaying an old tail
+        if (! isActive) {
+            for (int group = 0; group < numGroups; ++group) {
+                ic1[(size_t) (group * numSections) + i] = Vec::expand((FloatType) 0);
+                ic2[(size_t) (group * numSections) + i] = Vec::expand((FloatType) 0);
+            }
+        }
+
+        active[i] = isActive;
+        numActive += isActive ? 1 : -1;
+        activeChanged = true;
+    }
+
+    void rebuildActiveSections() noexcept {
+        activeSections.clear();
+        for (size_t i = 0; i < (size_t) numSections; ++i)
+            if (active[i])
+                activeSections.push_back((int) i);
+        activeChanged = false;
+    }
+
+    int numSections = 0, numGroups = 0;
+
+    ParameterArrays current, target, step;
+    std::vector<SvfTaps<Vec>> taps;   // of current, while it isn't ramping
+    std::vector<bool> ramping, neutral, targetNeutral;
+
+    // Integrator state, [group * numSections + section]
+    std::vector<Vec> ic1, ic2;
+
+    std::vector<bool> active;
+    std::vector<int> activeSections;
+    int numActive = 0;
+    bool activeChanged = false;
+};
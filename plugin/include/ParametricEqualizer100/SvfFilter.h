@@ -0,0 +1,66 @@
+#pragma once
+
+#include "BiquadFilter.h"
+
+// A topology-preserving transform (trapezoidal) state-variable filter section,
+// in Andrew Simper's form. g = tan(pi f / fs) sets the frequency and k = 1 / Q
+// the damping, and the output mixes the input with the band-pass and low-pass
+// outputs v1 and v2:
+//   y = m0 x + m1 v1 + m2 v2
+// which makes any second-order transfer function with those poles. The
+// cookbook designs are the bilinear transform with the same prewarping, so an
+// SVF section has exactly the response of the make* design it stands in for.
+// What differs is retuning: g and k can move every sample and the filter stays
+// stable for any g, k >= 0, where biquad coefficients changed that fast can
+// blow up.
+template <typename T>
+struct SvfCoefficients {
+    T g, k, m0, m1, m2;
+
+    // Passes the input through. The poles sit at z = 0, as they do for an
+    // identity biquad, so a section ramping out to this clears its state.
+    static SvfCoefficients identity() {
+        return { (T) 1, (T) 2, (T) 1, (T) 0, (T) 0 };
+    }
+
+    // From the analog prototype (c2 s^2 + c1 s + c0) / (s^2 + k s + 1), with s
+    // scaled so the poles are at g
+    static SvfCoefficients fromPrototype(double g, double k, double c2, double c1, double c0) {
+        return { (T) g, (T) k, (T) c2, (T) (c1 - c2 * k), (T) (c0 - c2) };
+    }
+
+    // The same filter as a biquad, for its decay and for telling when it's an
+    // identity
+    BiquadCoefficients<double> toBiquad() const {
+        const double gd = g, kd = k, g2 = gd * gd;
+        const double c2 = m0, c1 = m1 + m0 * kd, c0 = m2 + m0;
+        return BiquadCoefficients<double>::normalised(
+                c2 + gd * c1 + g2 * c0, 2.0 * (g2 * c0 - c2), c2 - gd * c1 + g2 * c0,
+                1.0 + gd * kd + g2, 2.0 * (g2 - 1.0), 1.0 - gd * kd + g2);
+    }
+
+    bool operator==(const SvfCoefficients&) const = default;
+};
+
+// The largest g the designers give, a hair below Nyquist (0.49997 fs), where
+// tan(pi f / fs) goes to infinity
+constexpr double svfMaxG = 1.0e4;
+
+// A section ready to run: g and k folded into a1 = 1 / (1 + g (g + k)),
+// a2 = g a1 and a3 = g a2
+template <typename T>
+struct SvfTaps {
+    T a1, a2, a3, m0, m1, m2;
+};
+
+// One step of the trapezoidal SVF. ic1 and ic2 are the two integrators' states.
+// The same kernel runs on scalars and on SIMD registers.
+template <typename T>
+inline T processSvfTPT(T x, const SvfTaps<T>& c, T& ic1, T& ic2) noexcept {
+    const T v3 = x - ic2;
+    const T v1 = c.a1 * ic1 + c.a2 * v3;
+    const T v2 = ic2 + c.a2 * ic1 + c.a3 * v3;
+    ic1 = v1 + v1 - ic1;
+    ic2 = v2 + v2 - ic2;
+    return c.m0 * x + c.m1 * v1 + c.m2 * v2;
+}
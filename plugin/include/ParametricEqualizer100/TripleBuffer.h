@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+// Wait-free handoff of whole values from one writer thread to one reader thread.
+// The writer fills its own buffer and publishes it by swapping it with the
+// middle one; the reader swaps the middle one for its own when something new is
+// there. Neither side ever sees a half-written value, and neither ever waits:
+// if the writer publishes twice before the reader looks, the reader just gets
+// the newer one.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& getWriteBuffer() noexcept { return buffers[(size_t) writeIndex]; }
+
+    void publish() noexcept {
+        writeIndex = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Whether the reader has yet to take the last published value. A false is
+    // final; a true may turn false any moment.
+    bool hasUnreadValue() const noexcept {
+        return (middle.load(std::memory_order_acquire) & freshBit) != 0;
+    }
+
+    // Reader side: takes the latest published value, if there is a new one
+    bool acquire() noexcept {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+            return false;
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const noexcept { return buffers[(size_t) readIndex]; }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int freshBit = 4;
+
+    std::array<T, 3> buffers {};
+    std::atomic<int> middle { 1 };
+    int writeIndex = 0;
+    int readIndex = 2;
+};
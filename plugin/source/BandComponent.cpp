@@ -0,0 +1,117 @@
+#include "ParametricEqualizer100/BandComponent.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+
+BandComponent::BandComponent(juce::AudioProcessorValueTreeState& apvts, int band)
+    : title("Band " + juce::String(band + 1)) {
+    const auto id = [band](const char* suffix) {
+        return AudioPluginAudioProcessor::getBandParameterID(band, suffix);
+    };
+
+    addAndMakeVisible(enabledButton);
+    enabledButton.setButtonText("On");
+    enabledAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        apvts, id("ON"), enabledButton);
+
+    // The items have to be there before the attachment
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter(id("TYPE"))))
+        typeBox.addItemList(choice->choices, 1);
+    addAndMakeVisible(typeBox);
+    typeBox.onChange = [this] { updateEnablement(); };
+    typeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        apvts, id("TYPE"), typeBox);
+
+    // Only matters in the Left/Right and Mid/Side stereo modes
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter(id("CHANNEL"))))
+        channelBox.addItemList(choice->choices, 1);
+    addAndMakeVisible(channelBox);
+    channelAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        apvts, id("CHANNEL"), channelBox);
+
+    // Slope and alignment, for the pass filters
+    const auto configureSlopeBox = [&](juce::ComboBox& box, const char* suffix,
+                                       std::unique_ptr<ComboBoxAttachment>& attachment) {
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter(id(suffix))))
+            box.addItemList(choice->choices, 1);
+        addAndMakeVisible(box);
+        box.onChange = [this] { updateEnablement(); };
+        attachment = std::make_unique<ComboBoxAttachment>(apvts, id(suffix), box);
+    };
+    configureSlopeBox(slopeBox, "SLOPE", slopeAttachment);
+    configureSlopeBox(alignmentBox, "ALIGN", alignmentAttachment);
+
+    const auto configureSlider = [&](juce::Slider& slider, const char* suffix,
+                                     std::unique_ptr<SliderAttachment>& attachment) {
+        slider.setSliderStyle(juce::Slider::Rotary);
+        slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 20);
+        addAndMakeVisible(slider);
+        attachment = std::make_unique<SliderAttachment>(apvts, id(suffix), slider);
+    };
+    configureSlider(freqSlider, "FREQ", freqAttachment);
+    configureSlider(gainSlider, "GAIN", gainAttachment);
+    configureSlider(qSlider, "Q", qAttachment);
+
+    // Dynamics: small horizontal sliders under the main controls
+    addAndMakeVisible(dynamicButton);
+    dynamicButton.setButtonText("Dynamic");
+    dynamicAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(
+        apvts, id("DYN"), dynamicButton);
+
+    const auto configureDynamicsSlider = [&](juce::Slider& slider, const char* suffix,
+                                             std::unique_ptr<SliderAttachment>& attachment) {
+        slider.setSliderStyle(juce::Slider::LinearHorizontal);
+        slider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 60, 16);
+        addAndMakeVisible(slider);
+        attachment = std::make_unique<SliderAttachment>(apvts, id(suffix), slider);
+    };
+    configureDynamicsSlider(thresholdSlider, "THRESH", thresholdAttachment);
+    configureDynamicsSlider(ratioSlider, "RATIO", ratioAttachment);
+    configureDynamicsSlider(attackSlider, "ATTACK", attackAttachment);
+    configureDynamicsSlider(releaseSlider, "RELEASE", releaseAttachment);
+
+    updateEnablement();
+}
+
+void BandComponent::updateEnablement() {
+    // Bell, low shelf and high shelf come before the pass filters
+    const bool hasGain = typeBox.getSelectedItemIndex() < 3;
+    for (auto* c : std::initializer_list<juce::Component*> { &gainSlider, &dynamicButton,
+                                                            &thresholdSlider, &ratioSlider,
+                                                            &attackSlider, &releaseSlider })
+        c->setEnabled(hasGain);
+
+    // A pass filter only takes its Q from the knob at 12 dB/oct Butterworth
+    slopeBox.setEnabled(! hasGain);
+    alignmentBox.setEnabled(! hasGain);
+    const int slope = AudioPluginAudioProcessor::passSlopes[(size_t) juce::jmax(0, slopeBox.getSelectedItemIndex())];
+    qSlider.setEnabled(hasGain || (slope == 12 && alignmentBox.getSelectedItemIndex() <= 0));
+}
+
+void BandComponent::paint(juce::Graphics& g) {
+    g.setColour(juce::Colours::white.withAlpha(0.1f));
+    g.drawRect(getLocalBounds());
+
+    g.setColour(juce::Colours::white);
+    g.setFont(15.0f);
+    g.drawFittedText(title, getLocalBounds().removeFromTop(24), juce::Justification::centred, 1);
+}
+
+void BandComponent::resized() {
+    auto area = getLocalBounds().reduced(4);
+    area.removeFromTop(24);   // title
+
+    enabledButton.setBounds(area.removeFromTop(24));
+    typeBox.setBounds(area.removeFromTop(24));
+    channelBox.setBounds(area.removeFromTop(24));
+    slopeBox.setBounds(area.removeFromTop(24));
+    alignmentBox.setBounds(area.removeFromTop(24));
+    area.removeFromTop(6);
+
+    auto dynamicsArea = area.removeFromBottom(24 + 4 * 36);
+    const int sliderHeight = area.getHeight() / 3;
+    for (auto* slider : { &freqSlider, &gainSlider, &qSlider })
+        slider->setBounds(area.removeFromTop(sliderHeight));
+
+    dynamicButton.setBounds(dynamicsArea.removeFromTop(24));
+    for (auto* slider : { &thresholdSlider, &ratioSlider, &attackSlider, &releaseSlider })
+        slider->setBounds(dynamicsArea.removeFromTop(36));
+}
@@ -0,0 +1,64 @@
+#include "ParametricEqualizer100/BinaryState.h"
+#include <cstring>
+
+namespace BinaryState {
+
+juce::uint32 hashParameterID(const juce::String& id) {
+    juce::uint32 hash = 2166136261u;
+    for (auto* c = id.toRawUTF8(); *c != 0; ++c) {
+        hash ^= (juce::uint8) *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void write(const std::vector<Entry>& entries, juce::MemoryBlock& dest) {
+    dest.setSize(headerSize + entries.size() * entrySize);
+    auto* out = static_cast<char*>(dest.getData());
+
+    const auto put = [&out](juce::uint32 v) {
+        v = juce::ByteOrder::swapIfBigEndian(v);
+        std::memcpy(out, &v, sizeof(v));
+        out += sizeof(v);
+    };
+
+    put(magic);
+    put(currentVersion);
+    put((juce::uint32) entries.size());
+    for (const auto& entry : entries) {
+        juce::uint32 bits;
+        std::memcpy(&bits, &entry.value, sizeof(bits));
+        put(entry.idHash);
+        put(bits);
+    }
+}
+
+bool read(const void* data, size_t size, std::vector<Entry>& entries) {
+    entries.clear();
+    if (data == nullptr || size < headerSize)
+        return false;
+
+    const auto* in = static_cast<const char*>(data);
+    const auto get = [in](size_t offset) {
+        return juce::ByteOrder::littleEndianInt(in + offset);
+    };
+
+    // Newer versions may add fields this one can't know about
+    if (get(0) != magic || get(4) == 0 || get(4) > currentVersion)
+        return false;
+
+    const auto count = (size_t) get(8);
+    if (count > (size - headerSize) / entrySize)
+        return false;
+
+    entries.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const size_t offset = headerSize + i * entrySize;
+        const juce::uint32 bits = get(offset + 4);
+        entries[i].idHash = get(offset);
+        std::memcpy(&entries[i].value, &bits, sizeof(bits));
+    }
+    return true;
+}
+
+} // namespace BinaryState
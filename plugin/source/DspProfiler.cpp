@@ -0,0 +1,21 @@
+#include "ParametricEqualizer100/DspProfiler.h"
+
+juce::String DspProfiler::toString(const Statistics& statistics) {
+    if (! enabled)
+        return "Profiling is not built in (PARAMETRIC_EQ_PROFILING)\n";
+
+    const auto line = [](const char* name, const StatisticsHistogram::Summary& s,
+                         const char* unit, int decimals) {
+        return juce::String(name).paddedRight(' ', 10)
+             + "p50 " + juce::String(s.p50, decimals) + unit
+             + "  p99 " + juce::String(s.p99, decimals) + unit
+             + "  max " + juce::String(s.max, decimals) + unit + "\n";
+    };
+
+    return juce::String((juce::uint64) statistics.blockMicroseconds.count) + " blocks\n"
+         + line("Block", statistics.blockMicroseconds, " us", 1)
+         + line("Design", statistics.designMicroseconds, " us", 1)
+         + line("Filter", statistics.filterMicroseconds, " us", 1)
+         + line("Load", statistics.loadPercent, " %", 1)
+         + line("Bands", statistics.activeBands, "", 0);
+}
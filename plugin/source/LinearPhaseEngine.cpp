@@ -0,0 +1,188 @@
+#include "ParametricEqualizer100/LinearPhaseEngine.h"
+#include "ParametricEqualizer100/BiquadFilter.h"
+#include <cmath>
+
+LinearPhaseEngine::LinearPhaseEngine(BandDesigner designer)
+    : juce::Thread("Linear phase designer"), designBands(std::move(designer)) {
+}
+
+LinearPhaseEngine::~LinearPhaseEngine() {
+    cancelPendingUpdate();
+    release();
+}
+
+int LinearPhaseEngine::firLengthFor(double sampleRate) {
+    return juce::nextPowerOfTwo((int) (sampleRate * 0.3));
+}
+
+void LinearPhaseEngine::prepare(double sampleRateToUse, int maxBlockSizeToUse, int numChannelsToUse) {
+    const juce::ScopedLock sl(buildLock);
+    tearDown();
+
+    sampleRate = sampleRateToUse;
+    maxBlockSize = maxBlockSizeToUse;
+    numPreparedChannels = numChannelsToUse;
+    firLength = firLengthFor(sampleRate);
+
+    if (enabled)
+        build();
+}
+
+void LinearPhaseEngine::release() {
+    const juce::ScopedLock sl(buildLock);
+    tearDown();
+    sampleRate = 0;
+}
+
+void LinearPhaseEngine::reset() noexcept {
+    const juce::SpinLock::ScopedTryLockType lock(engineLock);
+    if (lock.isLocked())
+        for (auto& convolution : convolutions)
+            convolution->reset();
+}
+
+void LinearPhaseEngine::setEnabled(bool shouldBeEnabled) {
+    enabled = shouldBeEnabled;
+    triggerAsyncUpdate();
+}
+
+void LinearPhaseEngine::handleAsyncUpdate() {
+    applyPendingChange();
+}
+
+void LinearPhaseEngine::applyPendingChange() {
+    // Nothing can be built before prepare(), which builds it if it's enabled by then
+    const juce::ScopedLock sl(buildLock);
+    if (sampleRate <= 0 || enabled == (loaderQueue != nullptr))
+        return;
+
+    if (enabled)
+        build();
+    else
+        tearDown();
+}
+
+void LinearPhaseEngine::requestUpdate() noexcept {
+    dirty = true;
+    wakeup.signal();
+}
+
+void LinearPhaseEngine::build() {
+    auto queue = std::make_unique<juce::dsp::ConvolutionMessageQueue>();
+    Convolutions engines;
+    for (int first = 0; first < numPreparedChannels; first += 2)
+        engines.push_back(std::make_unique<juce::dsp::Convolution>(
+                juce::dsp::Convolution::NonUniform { headSize }, *queue));
+
+    // A kernel loaded before prepare() is installed synchronously by it
+    dirty = false;
+    loadKernel(engines);
+    for (size_t pair = 0; pair < engines.size(); ++pair) {
+        const auto channelsInPair = (juce::uint32) juce::jmin(2, numPreparedChannels - (int) pair * 2);
+        engines[pair]->prepare({ sampleRate, (juce::uint32) maxBlockSize, channelsInPair });
+    }
+
+    {
+        const juce::SpinLock::ScopedLockType lock(engineLock);
+        loaderQueue.swap(queue);
+        convolutions.swap(engines);
+    }
+    ready = true;
+    startThread(juce::Thread::Priority::low);
+}
+
+void LinearPhaseEngine::tearDown() {
+    ready = false;
+    signalThreadShouldExit();
+    wakeup.signal();
+    stopThread(1000);
+
+    Convolutions engines;
+    std::unique_ptr<juce::dsp::ConvolutionMessageQueue> queue;
+    {
+        const juce::SpinLock::ScopedLockType lock(engineLock);
+        convolutions.swap(engines);
+        loaderQueue.swap(queue);
+    }
+
+    // The convolutions go before the queue they load through
+    engines.clear();
+    queue.reset();
+}
+
+void LinearPhaseEngine::run() {
+    // Sleeps until requestUpdate()
+    while (! threadShouldExit()) {
+        wakeup.wait();
+        if (! threadShouldExit() && dirty.exchange(false))
+            loadKernel(convolutions);
+    }
+}
+
+void LinearPhaseEngine::loadKernel(Convolutions& engines) {
+    juce::AudioBuffer<float> ir;
+    designImpulseResponse(designBands(sampleRate), firLength, ir);
+
+    // Each convolution crossfades from its old kernel once the new one is built
+    for (auto& convolution : engines) {
+        juce::AudioBuffer<float> copy(ir);
+        convolution->loadImpulseResponse(std::move(copy), sampleRate,
+                                         juce::dsp::Convolution::Stereo::no,
+                                         juce::dsp::Convolution::Trim::no,
+                                         juce::dsp::Convolution::Normalise::no);
+    }
+}
+
+void LinearPhaseEngine::designImpulseResponse(
+        const std::vector<std::array<double,6>>& bands, int firLength,
+        juce::AudioBuffer<float>& ir) {
+    jassert(juce::isPowerOfTwo(firLength));
+
+    std::vector<BiquadCoefficients<double>> sections;
+    for (const auto& c : bands)
+        sections.push_back(BiquadCoefficients<double>::normalised(c[0], c[1], c[2], c[3], c[4], c[5]));
+
+    // Real, zero-phase spectrum: only the magnitude of the cascade, bins 0..N/2.
+    // The inverse transform fills in the conjugate half itself.
+    juce::dsp::FFT fft(juce::roundToInt(std::log2((double) firLength)));
+    std::vector<float> data((size_t) (2 * firLength), 0.0f);
+    for (int k = 0; k <= firLength / 2; ++k) {
+        const double w = juce::MathConstants<double>::twoPi * k / firLength;
+        double magnitude = 1.0;
+        for (const auto& s : sections)
+            magnitude *= s.getMagnitude(w);
+        data[(size_t) (2 * k)] = (float) magnitude;
+    }
+    fft.performRealOnlyInverseTransform(data.data());
+
+    // The impulse is centred on sample 0 and wraps around; rotate it to the middle
+    // and window it so the truncation doesn't ripple across the response. The
+    // window is one longer so it is symmetric about firLength / 2, keeping the
+    // kernel exactly linear phase.
+    std::vector<float> window((size_t) firLength + 1);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(
+            window.data(), window.size(),
+            juce::dsp::WindowingFunction<float>::blackman, false);
+
+    ir.setSize(1, firLength);
+    auto* out = ir.getWritePointer(0);
+    for (int n = 0; n < firLength; ++n)
+        out[n] = data[(size_t) ((n + firLength / 2) % firLength)] * window[(size_t) n];
+}
+
+void LinearPhaseEngine::process(float* const* channels, int numChannels, int numSamples) noexcept {
+    // Only fails while the engine is being torn down, when the block passes through
+    const juce::SpinLock::ScopedTryLockType lock(engineLock);
+    if (! lock.isLocked())
+        return;
+
+    for (size_t pair = 0; pair < convolutions.size(); ++pair) {
+        const int first = (int) pair * 2;
+        if (first >= numChannels)
+            break;
+        juce::dsp::AudioBlock<float> block(channels + first,
+                                           (size_t) juce::jmin(2, numChannels - first),
+                                           (size_t) numSamples);
+        convolutions[pair]->process(juce::dsp::ProcessContextReplacing<float>(block));
+    }
+}
@@ -1,6 +1,7 @@
 #include "ParametricEqualizer100/PluginProcessor.h"
 #include "ParametricEqualizer100/PluginEditor.h"
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <algorithm>
 #include <cmath>
 
 // Constructor
@@ -13,80 +14,221 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        ),
+     linearPhase([this](double sampleRate) { return designTargetBands(sampleRate); }),
      apvts(*this, nullptr, "PARAMS", createParameterLayout()) {
-// Set any default parameters ?
+    // Look every parameter up once and get told when it moves
+    const auto attach = [this](const juce::String& id) {
+        apvts.addParameterListener(id, this);
+        return apvts.getRawParameterValue(id);
+    };
+
+    for (int band = 0; band < maxBands; ++band) {
+        auto& params = bandParameters[(size_t) band];
+        params.type = attach(getBandParameterID(band, "TYPE"));
+        params.enabled = attach(getBandParameterID(band, "ON"));
+        params.freq = attach(getBandParameterID(band, "FREQ"));
+        params.gain = attach(getBandParameterID(band, "GAIN"));
+        params.q = attach(getBandParameterID(band, "Q"));
+        params.dynamic = attach(getBandParameterID(band, "DYN"));
+        params.threshold = attach(getBandParameterID(band, "THRESH"));
+        params.ratio = attach(getBandParameterID(band, "RATIO"));
+        params.attack = attach(getBandParameterID(band, "ATTACK"));
+        params.release = attach(getBandParameterID(band, "RELEASE"));
+        params.channel = attach(getBandParameterID(band, "CHANNEL"));
+        params.slope = attach(getBandParameterID(band, "SLOPE"));
+        params.alignment = attach(getBandParameterID(band, "ALIGN"));
+
+        bandDirty[(size_t) band] = true;
+        responseDirty[(size_t) band] = true;
+    }
+
+    linearPhaseParam = attach("LINEARPHASE");
+    oversamplingParam = attach("OVERSAMPLING");
+    stereoParam = attach("STEREO");
+    // Picked up by the audio thread, which moves the bands across itself
+    engineParam = apvts.getRawParameterValue("ENGINE");
+
+    // The design paths never queue more than every section of every band, so
+    // they never allocate
+    batchDesigner.reserve(maxBands * maxSectionsPerBand);
+    dynamicsDesigner.reserve(maxBands);
+
+    for (auto* param : getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            stateSlots.push_back({ BinaryState::hashParameterID(ranged->paramID), ranged });
+    stateSlotsByHash = stateSlots;
+    std::sort(stateSlotsByHash.begin(), stateSlotsByHash.end(),
+              [](const StateSlot& a, const StateSlot& b) { return a.idHash < b.idHash; });
+    jassert(std::adjacent_find(stateSlotsByHash.begin(), stateSlotsByHash.end(),
+                               [](const StateSlot& a, const StateSlot& b) { return a.idHash == b.idHash; })
+            == stateSlotsByHash.end());
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor() {
+    designThread->remove(*this);
+    linearPhase.release();
+    apvts.removeParameterListener("LINEARPHASE", this);
+    apvts.removeParameterListener("OVERSAMPLING", this);
+    apvts.removeParameterListener("STEREO", this);
+    for (int band = 0; band < maxBands; ++band)
+        for (const char* suffix : bandParameterSuffixes)
+            apvts.removeParameterListener(getBandParameterID(band, suffix), this);
+}
+
+juce::String AudioPluginAudioProcessor::getBandParameterID(int band, const char* suffix) {
+    return "BAND" + juce::String(band + 1) + suffix;
+}
+
+void AudioPluginAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue) {
+    // Both change the delay, which the host is told about once the audio thread
+    // has actually switched paths
+    if (parameterID == "LINEARPHASE") {
+        linearPhase.setEnabled(newValue > 0.5f);
+        return;
+    }
+    if (parameterID == "OVERSAMPLING")
+        return;
+    // Every band may now sit on other lanes
+    if (parameterID == "STEREO") {
+        for (auto& dirty : bandDirty)
+            dirty = true;
+        if (! loadingState)
+            requestDesign();
+        return;
+    }
+
+    // Everything else is a BAND<n>... parameter
+    const int band = parameterID.substring(4).getIntValue() - 1;
+    if (juce::isPositiveAndBelow(band, maxBands)) {
+        bandDirty[(size_t) band] = true;
+        responseDirty[(size_t) band] = true;
+    }
+
+    // A state load asks for the designs once it has set everything
+    if (loadingState)
+        return;
+    if (juce::isPositiveAndBelow(band, maxBands))
+        requestDesign();
+    if (isLinearPhase())
+        linearPhase.requestUpdate();
 }
 
 // Parameter Layout
 juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginAudioProcessor::createParameterLayout()
 {
     std::vector<std::unique_ptr<juce::RangedAudioParameter>> params;
-    // High Pass
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "HPFREQ",   // ID
-                "High Pass Frequency", // name
-                juce::NormalisableRange<float>(0.0f, 20000.0f, 0.01f, 0.5f),
-                                                                 30.0f)); // default value
-    // Low Pass
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "LPFREQ", 
-                "Low Pass Frequency",
-                juce::NormalisableRange<float>(0.0f, 20000.0f, 0.01f, 0.5f),
-                                                                 18000.0f));
-    // Bell 1
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL1FREQ", 
-                "Bell1 Frequency",
-                juce::NormalisableRange<float>(0.0f, 20000.0f, 0.01f, 0.5f),
-                                                                 200.0f));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL1GAIN", 
-                "Bell1 Gain (dB)",
-                juce::NormalisableRange<float>(-24.0f, 24.0f, 0.1f),
-                                                             0.0f));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL1Q", 
-                "Bell1 Q",
-                juce::NormalisableRange<float>(0.1f, 10.0f, 0.01f),
-                                                            0.707f));
-    // Bell 2
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL2FREQ", 
-                "Bell2 Frequency", 
-                juce::NormalisableRange<float>(0.0f, 20000.0f, 0.01f, 0.5f), 1000.0f));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL2GAIN", 
-                "Bell2 Gain (dB)", 
-                juce::NormalisableRange<float>(-24.0f, 24.0f, 0.1f), 3.0f));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL2Q",    
-                "Bell2 Q", 
-                juce::NormalisableRange<float>(0.1f, 10.0f, 0.01f), 0.707f));
-    // Bell 3
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL3FREQ", 
-                "Bell3 Frequency", 
-                juce::NormalisableRange<float>(0.0f, 20000.0f, 0.01f, 0.5f), 5000.0f));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL3GAIN", 
-                "Bell3 Gain (dB)", 
-                juce::NormalisableRange<float>(-24.0f, 24.0f, 0.1f), -2.0f));
-    params.push_back(std::make_unique<juce::AudioParameterFloat>(
-                "BELL3Q",    
-                "Bell3 Q", 
-                juce::NormalisableRange<float>(0.1f, 10.0f, 0.01f), 0.707f));
-    // Boolean parameters for shelf modes
-    params.push_back(std::make_unique<juce::AudioParameterBool>(
-                "ISLOWSHELFMODE", 
-                "Is Low Shelf Mode", 
-                false));
+
+    // The first five bands start out as a high pass, three bells and a low pass;
+    // the rest start off
+    struct BandDefaults {
+        FilterType type;
+        float freq, gain;
+        bool enabled;
+    };
+    const BandDefaults defaults[] {
+        { FilterType::highPass,  30.0f,    0.0f, true },
+        { FilterType::peaking,   200.0f,   0.0f, true },
+        { FilterType::peaking,   1000.0f,  3.0f, true },
+        { FilterType::peaking,   5000.0f, -2.0f, true },
+        { FilterType::lowPass,   18000.0f, 0.0f, true },
+    };
+
+    for (int band = 0; band < maxBands; ++band) {
+        const auto d = band < (int) std::size(defaults) ? defaults[band]
+                                                        : BandDefaults { FilterType::peaking, 1000.0f, 0.0f, false };
+        const auto id = [band](const char* suffix) { return getBandParameterID(band, suffix); };
+        const auto name = "Band " + juce::String(band + 1);
+
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+                    id("TYPE"),
+                    name + " Type",
+                    juce::StringArray { "Bell", "Low Shelf", "High Shelf", "High Pass", "Low Pass" },
+                    (int) (std::find(bandTypes.begin(), bandTypes.end(), d.type) - bandTypes.begin())));
+        params.push_back(std::make_unique<juce::AudioParameterBool>(
+                    id("ON"),
+                    name + " On",
+                    d.enabled));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+                    id("FREQ"),
+                    name + " Frequency",
+                    juce::NormalisableRange<float>(0.0f, 20000.0f, 0.01f, 0.5f), d.freq));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+                    id("GAIN"),
+                    name + " Gain (dB)",
+                    juce::NormalisableRange<float>(-24.0f, 24.0f, 0.1f), d.gain));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+                    id("Q"),
+                    name + " Q",
+                    juce::NormalisableRange<float>(0.1f, 10.0f, 0.01f), 0.707f));
+
+        // Dynamics, for bells and shelves
+        params.push_back(std::make_unique<juce::AudioParameterBool>(
+                    id("DYN"),
+                    name + " Dynamic",
+                    false));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+                    id("THRESH"),
+                    name + " Threshold (dB)",
+                    juce::NormalisableRange<float>(-60.0f, 0.0f, 0.1f), -20.0f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+                    id("RATIO"),
+                    name + " Ratio",
+                    juce::NormalisableRange<float>(1.0f, 20.0f, 0.1f, 0.5f), 4.0f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+                    id("ATTACK"),
+                    name + " Attack (ms)",
+                    juce::NormalisableRange<float>(0.1f, 200.0f, 0.1f, 0.4f), 10.0f));
+        params.push_back(std::make_unique<juce::AudioParameterFloat>(
+                    id("RELEASE"),
+                    name + " Release (ms)",
+                    juce::NormalisableRange<float>(5.0f, 2000.0f, 1.0f, 0.4f), 100.0f));
+
+        // Which channel of a stereo pair, or of mid and side, the band is on
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+                    id("CHANNEL"),
+                    name + " Channel",
+                    juce::StringArray { "Both", "Left / Mid", "Right / Side" },
+                    0));
+
+        // How steeply a high or low pass falls off, and the shape of its knee
+        juce::StringArray slopeNames;
+        for (int slope : passSlopes)
+            slopeNames.add(juce::String(slope) + " dB/oct");
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+                    id("SLOPE"),
+                    name + " Slope",
+                    slopeNames,
+                    (int) (std::find(passSlopes.begin(), passSlopes.end(), 12) - passSlopes.begin())));
+        params.push_back(std::make_unique<juce::AudioParameterChoice>(
+                    id("ALIGN"),
+                    name + " Alignment",
+                    juce::StringArray { "Butterworth", "Linkwitz-Riley" },
+                    0));
+    }
+
+    // Linear phase: same magnitude response, no phase shift, at the cost of latency
     params.push_back(std::make_unique<juce::AudioParameterBool>(
-                "ISHIGHSHELFMODE",
-                "Is High Shelf Mode", 
+                "LINEARPHASE",
+                "Linear Phase",
                 false));
+    // Oversampling around the biquads, 2^index times the host rate
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+                "OVERSAMPLING",
+                "Oversampling",
+                juce::StringArray { "Off", "2x", "4x" },
+                0));
+    // How the bands of a stereo pair are laid out, see StereoMode
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+                "STEREO",
+                "Stereo Mode",
+                juce::StringArray { "Linked", "Left / Right", "Mid / Side" },
+                0));
+    // What the cascade's sections are, see FilterEngine
+    params.push_back(std::make_unique<juce::AudioParameterChoice>(
+                "ENGINE",
+                "Filter Engine",
+                juce::StringArray { "Biquad", "State Variable" },
+                0));
     return { params.begin(), params.end() };
 }
 
@@ -120,26 +262,80 @@ bool AudioPluginAudioProcessor::isMidiEffect() const {
 }
 
 double AudioPluginAudioProcessor::getTailLengthSeconds() const {
-    return 0.0;
+    // From the bands as set, so it's right before anything has played
+    const double sampleRate = getSampleRate();
+    if (sampleRate <= 0.0)
+        return 0.0;
+
+    double decaySamples = 0.0;
+    for (const auto& band : designTargetBands(sampleRate)) {
+        const auto c = BiquadCoefficients<double>::normalised(band[0], band[1], band[2],
+                                                              band[3], band[4], band[5]);
+        if (! c.isIdentity(1.0e-12))
+            decaySamples += c.getDecaySamples(tailDecayDb);
+    }
+    return computeTailSamples(decaySamples, isLinearPhase(), getOversamplingParamOrder()) / sampleRate;
+}
+
+double AudioPluginAudioProcessor::computeTailSamples(
+        double cascadeDecaySamples, bool linear, int order) const {
+    // The linear-phase FIR rings for its whole length; the cascade for as long as
+    // its sections take to decay, delayed by any oversampling. Capped, so an
+    // unstable setting doesn't keep the filters running forever.
+    const double samples = linear ? 2.0 * computeLatencySamples(true, order)
+                                  : cascadeDecaySamples + computeLatencySamples(false, order);
+    return juce::jmin(samples + tailMarginSamples, maxTailSeconds * getSampleRate());
 }
 //==============================================================================
 // Program Stuff (Old School Presets)
+juce::File AudioPluginAudioProcessor::getDefaultPresetBankFile() {
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("ParametricEqualizer100")
+        .getChildFile("Presets.peqb");
+}
+
+const PresetBank& AudioPluginAudioProcessor::DefaultPresetBank::get() {
+    const juce::ScopedLock sl(lock);
+    if (! opened) {
+        bank.open(getDefaultPresetBankFile());
+        opened = true;
+    }
+    return bank;
+}
+
+const PresetBank& AudioPluginAudioProcessor::getPresetBank() {
+    return loadedPresetBank != nullptr ? *loadedPresetBank : defaultPresetBank->get();
+}
+
+bool AudioPluginAudioProcessor::loadPresetBank(const juce::File& file) {
+    auto bank = std::make_unique<PresetBank>();
+    const bool opened = bank->open(file);
+    loadedPresetBank = std::move(bank);
+    currentProgram = 0;
+    updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    return opened;
+}
+
 int AudioPluginAudioProcessor::getNumPrograms() {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // NB: some hosts don't cope very well if you tell them there are 0 programs,
+    // so this should be at least 1, even without a bank.
+    return juce::jmax(1, getPresetBank().getNumPresets());
 }
 
 int AudioPluginAudioProcessor::getCurrentProgram() {
-    return 0;
+    return currentProgram;
 }
 
 void AudioPluginAudioProcessor::setCurrentProgram (int index) {
-    juce::ignoreUnused (index);
+    size_t size = 0;
+    if (const void* state = getPresetBank().getPresetState(index, size)) {
+        setStateInformation(state, (int) size);
+        currentProgram = index;
+    }
 }
 
 const juce::String AudioPluginAudioProcessor::getProgramName (int index) {
-    juce::ignoreUnused (index);
-    return {};
+    return getPresetBank().getPresetName(index);
 }
 
 void AudioPluginAudioProcessor::changeProgramName (
@@ -152,66 +348,595 @@ void AudioPluginAudioProcessor::changeProgramName (
 void AudioPluginAudioProcessor::prepareToPlay (
         double sampleRate, int samplesPerBlock
         ) {
-    juce::ignoreUnused (samplesPerBlock);
-
-    highPassFilter.reset();
-    bell1Filter.reset();
-    bell2Filter.reset();
-    bell3Filter.reset();
-    lowPassFilter.reset();
-
-    double highPassFreq = *apvts.getRawParameterValue("HPFREQ");
-    double lowPassFreq = *apvts.getRawParameterValue("LPFREQ");
-
-    double bell1Freq = *apvts.getRawParameterValue("BELL1FREQ");
-    double bell1Gain = *apvts.getRawParameterValue("BELL1GAIN");
-    double bell1Q = *apvts.getRawParameterValue("BELL1Q");
-
-    double bell2Freq = *apvts.getRawParameterValue("BELL2FREQ");
-    double bell2Gain = *apvts.getRawParameterValue("BELL2GAIN");
-    double bell2Q = *apvts.getRawParameterValue("BELL2Q");
-    
-    double bell3Freq = *apvts.getRawParameterValue("BELL3FREQ");
-    double bell3Gain = *apvts.getRawParameterValue("BELL3GAIN");
-    double bell3Q = *apvts.getRawParameterValue("BELL3Q");
-
-    bool isLowShelfMode = *apvts
-        .getRawParameterValue("ISLOWSHELFMODE") > 0.5f;
-    bool isHighShelfMode = *apvts
-        .getRawParameterValue("ISHIGHSHELFMODE") > 0.5f;
+    const int numChannels = getTotalNumInputChannels();
 
-    // Using the EQ Cookbook formulas:
-    auto highPassCoefs = makeHighPass(sampleRate, highPassFreq, 0.707); // Q=0.707 as an example
-    highPassFilter.setCoefficients(highPassCoefs[0], highPassCoefs[1], highPassCoefs[2], 
-                                   highPassCoefs[3], highPassCoefs[4], highPassCoefs[5]);
-    // Choose between the Low Shelf and the bell
-    if (isLowShelfMode) {
-        auto lowShelfCoefs = makeLowShelf(sampleRate, bell1Freq, bell1Q, bell1Gain);
-        bell1Filter.setCoefficients(lowShelfCoefs[0], lowShelfCoefs[1], lowShelfCoefs[2],
-                                    lowShelfCoefs[3], lowShelfCoefs[4], lowShelfCoefs[5]);
+    // Offline renders design inline, so the result doesn't depend on thread timing.
+    // Hosts switch to non-realtime before preparing for a bounce.
+    designThread->remove(*this);
+    threadedDesign = ! isNonRealtime();
+    designerSampleRate = 0;
+
+    // processBlock never runs more than one control interval through the filters,
+    // which is 2^order times as many samples when oversampling
+    channelLanes.prepare(numChannels, controlInterval << maxOversamplingOrder);
+
+    cascade.prepare(maxBands * maxSectionsPerBand, channelLanes.getNumGroups());
+    svfCascade.prepare(maxBands * maxSectionsPerBand, channelLanes.getNumGroups());
+    sectionsInUse.fill(0);
+    activeEngine = getFilterEngine();
+    silentSamples = 0;
+    idle = false;
+    for (auto& detector : detectors)
+        detector.prepare(channelLanes.getNumGroups());
+    detectorScratch.resize((size_t) channelLanes.getMaxSamples());
+
+    for (int order = 1; order <= maxOversamplingOrder; ++order) {
+        auto& oversampler = oversamplers[(size_t) order - 1];
+        oversampler = std::make_unique<juce::dsp::Oversampling<float>>(
+                (size_t) juce::jmax(1, numChannels), (size_t) order,
+                juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                false, true);
+        oversampler->initProcessing((size_t) samplesPerBlock);
     }
-    else {
-        auto bell1Coefs = makePeaking(sampleRate, bell1Freq, bell1Q, bell1Gain);
-        bell1Filter.setCoefficients(bell1Coefs[0], bell1Coefs[1], bell1Coefs[2],
-                bell1Coefs[3], bell1Coefs[4], bell1Coefs[5]);
-    }
-    auto bell2Coefs = makePeaking(sampleRate, bell2Freq, bell2Q, bell2Gain);
-    bell2Filter.setCoefficients(bell2Coefs[0], bell2Coefs[1], bell2Coefs[2],
-                                bell2Coefs[3], bell2Coefs[4], bell2Coefs[5]);
-    // Choose between the High Shelf and the bell
-    if (isHighShelfMode) {
-        auto highShelfCoefs = makeHighShelf(sampleRate, bell3Freq, bell3Q, bell3Gain);
-        bell3Filter.setCoefficients(highShelfCoefs[0], highShelfCoefs[1], highShelfCoefs[2],
-                                    highShelfCoefs[3], highShelfCoefs[4], highShelfCoefs[5]);
+    oversampledChannels.assign((size_t) numChannels, nullptr);
+    floatBuffer.setSize(juce::jmax(1, numChannels), juce::jmax(1, samplesPerBlock), false, false, true);
+
+    // The sample rate may have changed, so everything gets redesigned
+    setOversamplingOrder(getOversamplingParamOrder());
+
+    linearPhase.setEnabled(isLinearPhase());
+    linearPhase.prepare(sampleRate, samplesPerBlock, numChannels);
+    analyzer.prepare(sampleRate);
+    linearPhaseActive = isLinearPhase() && linearPhase.isReady();
+    setLatencySamples(computeLatencySamples(linearPhaseActive, oversamplingOrder));
+
+    // The first set at the new rate is designed right here, off the audio
+    // thread, so the first block is already filtered
+    if (threadedDesign) {
+        appliedBands = {};
+        appliedLanes = {};
+        designCoefficients();
+        applyDesignedCoefficients(getSampleRate() * (1 << oversamplingOrder), 0);
+        designThread->add(*this);
+    }
+}
+
+void AudioPluginAudioProcessor::setOversamplingOrder(int order) {
+    oversamplingOrder = juce::jlimit(0, maxOversamplingOrder, order);
+    const double sampleRate = getSampleRate() * (1 << oversamplingOrder);
+    runningTailDirty = true;
+
+    if (threadedDesign) {
+        // The smoothers belong to the design thread, which restarts them at the new
+        // rate and sends every band. The audio thread never designs: until that
+        // set arrives the cascade runs the bands it has.
+        designSampleRate = sampleRate;
+        requestDesign();
     }
     else {
-        auto bell3Coefs = makePeaking(sampleRate, bell3Freq, bell3Q, bell3Gain);
-        bell3Filter.setCoefficients(bell3Coefs[0], bell3Coefs[1], bell3Coefs[2],
-                bell3Coefs[3], bell3Coefs[4], bell3Coefs[5]);
+        for (int band = 0; band < maxBands; ++band) {
+            bandDirty[(size_t) band] = false;
+            smoothers[(size_t) band].reset(sampleRate, smoothingTimeSeconds);
+            updateSmootherTargets(band, true);
+            updateBandCoefficients(band, sampleRate, 0);
+        }
+    }
+
+    cascade.reset();
+    svfCascade.reset();
+    for (auto& detector : detectors)
+        detector.reset();
+    for (auto& oversampler : oversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+    // The host re-aligns everything around the new delay
+    if (! linearPhaseActive)
+        setLatencySamples(computeLatencySamples(false, oversamplingOrder));
+}
+
+const ResponseEvaluator::Curve& AudioPluginAudioProcessor::getFrequencyResponse(int numPoints) {
+    // Before prepareToPlay there is no rate yet, so show it at a typical one
+    const double hostRate = getSampleRate() > 0.0 ? getSampleRate() : 48000.0;
+
+    // The cascade is designed at the oversampled rate, and that is what is heard
+    const int order = isLinearPhase() ? 0 : juce::jlimit(0, maxOversamplingOrder, getOversamplingParamOrder());
+    const double sampleRate = hostRate * (1 << order);
+
+    // A new grid needs every band again; otherwise only the bands that moved are
+    // designed, and evaluated if that changed them
+    const bool newGrid = responseEvaluator.setGrid(numPoints, sampleRate);
+    responseEvaluator.setNumBands(maxBands);
+    for (int band = 0; band < maxBands; ++band) {
+        if (! responseDirty[(size_t) band].exchange(false) && ! newGrid)
+            continue;
+        const auto design = designTargetBand(band, sampleRate);
+        responseEvaluator.setBand(band, design.sections.data(), design.numSections);
+    }
+    responseEvaluator.update();
+    return responseEvaluator.getCurve();
+}
+
+int AudioPluginAudioProcessor::computeLatencySamples(bool linear, int order) const {
+    if (linear)
+        return linearPhase.getLatencySamples();
+
+    // Oversamplers were built with integer latency
+    order = juce::jlimit(0, maxOversamplingOrder, order);
+    const auto& oversampler = order > 0 ? oversamplers[(size_t) order - 1] : nullptr;
+    return oversampler != nullptr ? juce::roundToInt(oversampler->getLatencyInSamples()) : 0;
+}
+
+void AudioPluginAudioProcessor::setControlInterval(int numSamples) {
+    controlInterval = juce::jmax(1, numSamples);
+}
+
+void AudioPluginAudioProcessor::updateSmootherTargets(int band, bool jump) {
+    const auto& params = bandParameters[(size_t) band];
+    auto& smoother = smoothers[(size_t) band];
+
+    const auto update = [jump](juce::SmoothedValue<float>& value, std::atomic<float>* param) {
+        if (param == nullptr)
+            return;
+        if (jump)
+            value.setCurrentAndTargetValue(*param);
+        else
+            value.setTargetValue(*param);
+    };
+    update(smoother.freq, params.freq);
+    update(smoother.gain, params.gain);
+    update(smoother.q, params.q);
+}
+
+void AudioPluginAudioProcessor::updateBandCoefficients(
+        int band, double sampleRate, int rampLength) {
+    const auto& smoother = smoothers[(size_t) band];
+    const auto design = designBand(band, sampleRate,
+                                   smoother.freq.getCurrentValue(),
+                                   smoother.gain.getCurrentValue(),
+                                   smoother.q.getCurrentValue());
+    setBandSections(band, design, rampLength, getBandLanes(band));
+}
+
+void AudioPluginAudioProcessor::setBandSections(
+        int band, const BandDesign& design, int rampLength, LaneMask lanes) {
+    runningTailDirty = true;
+    auto& inUse = sectionsInUse[(size_t) band];
+    for (int k = 0; k < juce::jmax(design.numSections, inUse); ++k) {
+        const int section = band * maxSectionsPerBand + k;
+        if (activeEngine == FilterEngine::stateVariable) {
+            const auto svf = k < design.numSections ? design.svfSections[(size_t) k]
+                                                    : SvfCoefficients<double>::identity();
+            if (rampLength > 0)
+                svfCascade.setTargetCoefficients(section, svf, rampLength, lanes);
+            else
+                svfCascade.setCoefficients(section, svf, lanes);
+            continue;
+        }
+
+        const auto& c = k < design.numSections ? design.sections[(size_t) k] : bypassedBand;
+        if (rampLength > 0)
+            cascade.setTargetCoefficients(section, c[0], c[1], c[2], c[3], c[4], c[5], rampLength, lanes);
+        else
+            cascade.setCoefficients(section, c[0], c[1], c[2], c[3], c[4], c[5], lanes);
+    }
+    inUse = design.numSections;
+}
+
+AudioPluginAudioProcessor::BandDesign AudioPluginAudioProcessor::designTargetBand(
+        int band, double sampleRate) const {
+    const auto read = [](std::atomic<float>* param) {
+        return param != nullptr ? (double) param->load() : 0.0;
+    };
+
+    const auto& params = bandParameters[(size_t) band];
+    return designBand(band, sampleRate, read(params.freq), read(params.gain), read(params.q));
+}
+
+std::vector<std::array<double,6>> AudioPluginAudioProcessor::designTargetBands(
+        double sampleRate) const {
+    std::vector<std::array<double,6>> bands;
+    for (int band = 0; band < maxBands; ++band) {
+        const auto design = designTargetBand(band, sampleRate);
+        for (int k = 0; k < design.numSections; ++k)
+            bands.push_back(design.sections[(size_t) k]);
+    }
+    return bands;
+}
+
+//==============================================================================
+AudioPluginAudioProcessor::DesignThread::DesignThread()
+    : juce::Thread("Coefficient designer") {
+    startThread(juce::Thread::Priority::normal);
+}
+
+AudioPluginAudioProcessor::DesignThread::~DesignThread() {
+    signalThreadShouldExit();
+    work.signal();
+    stopThread(1000);
+}
+
+void AudioPluginAudioProcessor::DesignThread::add(AudioPluginAudioProcessor& processor) {
+    const juce::ScopedLock sl(lock);
+    processors.add(&processor);
+}
+
+void AudioPluginAudioProcessor::DesignThread::remove(AudioPluginAudioProcessor& processor) {
+    {
+        const juce::ScopedLock sl(lock);
+        processors.removeValue(&processor);
+    }
+
+    // Once this returns the thread is done with the processor. The lock is only
+    // ever held for a moment, so this waits at most for one design of our own.
+    while (processor.designBusy.load(std::memory_order_acquire))
+        juce::Thread::yield();
+}
+
+void AudioPluginAudioProcessor::DesignThread::run() {
+    juce::SortedSet<AudioPluginAudioProcessor*> snapshot;
+    while (! threadShouldExit()) {
+        work.wait();
+
+        {
+            const juce::ScopedLock sl(lock);
+            snapshot = processors;
+        }
+
+        // Designs happen outside the lock, so creating or destroying an instance
+        // never waits for the others to be designed. One removed since the
+        // snapshot may be gone already, and is skipped without being touched.
+        for (auto* processor : snapshot) {
+            {
+                const juce::ScopedLock sl(lock);
+                if (! processors.contains(processor) || ! processor->designRequested.load())
+                    continue;
+                processor->designBusy = true;
+            }
+            if (processor->designRequested.exchange(false))
+                processor->designCoefficients();
+            processor->designBusy.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void AudioPluginAudioProcessor::requestDesign() noexcept {
+    designRequested = true;
+    designThread->wake();
+}
+
+void AudioPluginAudioProcessor::designCoefficients() {
+    const double sampleRate = designSampleRate.load();
+    const auto played = samplesPlayed.load(std::memory_order_acquire);
+    bool changed = false, smoothing = false;
+
+    // New rate or a freshly loaded state: start every band from its target
+    if (snapToTargets.exchange(false) || sampleRate != designerSampleRate) {
+        designerSampleRate = sampleRate;
+        for (int band = 0; band < maxBands; ++band) {
+            bandDirty[(size_t) band] = false;
+            smoothers[(size_t) band].reset(sampleRate, smoothingTimeSeconds);
+            updateSmootherTargets(band, true);
+        }
+        designedSamples = played;
+        changed = true;
+    }
+
+    // The smoothers move on by as many samples as the audio thread has played
+    // since the last design, so a ramp is as long as it is offline
+    const int elapsed = (int) juce::jlimit((juce::int64) 0, (juce::int64) sampleRate, played - designedSamples);
+    designedSamples = played;
+
+    batchDesigner.clear();
+    std::array<QueuedBand, maxBands> queuedBands {};
+    int numQueued = 0;
+    juce::uint32 changedBands = 0;
+    for (int band = 0; band < maxBands; ++band) {
+        const bool dirty = bandDirty[(size_t) band].exchange(false);
+        if (dirty)
+            updateSmootherTargets(band, false);
+
+        auto& smoother = smoothers[(size_t) band];
+        if (dirty || changed || (smoother.isSmoothing() && elapsed > 0)) {
+            smoother.skip(elapsed);
+            designedSettings[(size_t) band] = { smoother.freq.getCurrentValue(),
+                                                smoother.gain.getCurrentValue(),
+                                                smoother.q.getCurrentValue() };
+            queuedBands[(size_t) numQueued++] = queueSmoothedBand(band, sampleRate);
+            changedBands |= 1u << band;
+            changed = true;
+        }
+        smoothing = smoothing || smoother.isSmoothing();
+    }
+
+    batchDesigner.design();
+    for (int i = 0; i < numQueued; ++i) {
+        const auto& queued = queuedBands[(size_t) i];
+        designedBands[(size_t) queued.band] = getDesignedBand(queued);
+    }
+
+    if (changed) {
+        auto& set = coefficientSets.getWriteBuffer();
+        set.bands = designedBands;
+        set.settings = designedSettings;
+        set.sampleRate = sampleRate;
+
+        // A set still waiting is replaced before the audio thread saw its bands
+        set.changedBands = changedBands
+                         | (coefficientSets.hasUnreadValue() ? publishedChangedBands : 0u);
+        publishedChangedBands = set.changedBands;
+        coefficientSets.publish();
+    }
+    designSmoothing = smoothing;
+}
+
+void AudioPluginAudioProcessor::applyDesignedCoefficients(double sampleRate, int rampLength) {
+    if (! coefficientSets.acquire())
+        return;
+
+    // A set designed for a rate we have since left is stale
+    const auto& set = coefficientSets.getReadBuffer();
+    if (set.sampleRate != sampleRate)
+        return;
+
+    appliedSettings = set.settings;
+
+    // Only the bands that were redesigned. A band coming out of dynamic mode or
+    // moved to other lanes is marked dirty by its parameter, so it's among them.
+    for (int band = 0; band < maxBands; ++band) {
+        if (((set.changedBands >> band) & 1) == 0)
+            continue;
+
+        const auto& design = set.bands[(size_t) band];
+        const auto lanes = getBandLanes(band);
+        if ((design == appliedBands[(size_t) band] && lanes == appliedLanes[(size_t) band])
+            || isBandDynamic(band))
+            continue;
+        setBandSections(band, design, rampLength, lanes);
+        appliedBands[(size_t) band] = design;
+        appliedLanes[(size_t) band] = lanes;
+    }
+}
+
+bool AudioPluginAudioProcessor::isBandDynamic(int band) const {
+    const auto type = getBandType(band);
+    return *bandParameters[(size_t) band].dynamic > 0.5f && isBandEnabled(band)
+        && (type == FilterType::peaking || type == FilterType::lowShelf || type == FilterType::highShelf);
+}
+
+DynamicsSettings AudioPluginAudioProcessor::getDynamicsSettings(int band) const {
+    const auto& params = bandParameters[(size_t) band];
+    return { *params.threshold, *params.ratio, *params.attack, *params.release };
+}
+
+AudioPluginAudioProcessor::BandSettings AudioPluginAudioProcessor::getCurrentBandSettings(int band) const {
+    // While the design thread owns the smoothers, it says where they are
+    if (threadedDesign)
+        return appliedSettings[(size_t) band];
+
+    const auto& smoother = smoothers[(size_t) band];
+    return { smoother.freq.getCurrentValue(), smoother.gain.getCurrentValue(), smoother.q.getCurrentValue() };
+}
+
+void AudioPluginAudioProcessor::processDynamics(double sampleRate, int blockSize) {
+    // Detector filters first: a band pass around a bell, the shelf's side of a shelf
+    dynamicsDesigner.clear();
+    std::array<int, maxBands> dynamicBands {};
+    int numDynamic = 0;
+    for (int band = 0; band < maxBands; ++band) {
+        if (! isBandDynamic(band)) {
+            detectorActive[(size_t) band] = false;
+            continue;
+        }
+
+        // A band going dynamic starts listening from silence
+        if (! detectorActive[(size_t) band]) {
+            detectors[(size_t) band].reset();
+            detectorActive[(size_t) band] = true;
+        }
+
+        const auto settings = getCurrentBandSettings(band);
+        const auto type = getBandType(band);
+        const auto detectorType = type == FilterType::lowShelf  ? FilterType::lowPass
+                                : type == FilterType::highShelf ? FilterType::highPass
+                                                                : FilterType::bandPass;
+        dynamicsDesigner.add(detectorType, sampleRate, settings.freq,
+                             detectorType == FilterType::bandPass ? settings.q : 0.707);
+        dynamicBands[(size_t) numDynamic++] = band;
+    }
+
+    if (numDynamic == 0)
+        return;
+
+    dynamicsDesigner.design();
+    std::array<double, maxBands> gainChanges {};
+    for (int i = 0; i < numDynamic; ++i) {
+        const int band = dynamicBands[(size_t) i];
+        auto& detector = detectors[(size_t) band];
+        detector.setFilter(dynamicsDesigner.getCoefficients(i));
+        for (int group = 0; group < channelLanes.getNumGroups(); ++group)
+            detector.measure(channelLanes.getGroup(group), detectorScratch.data(), blockSize, group,
+                             getBandLanes(band));
+        gainChanges[(size_t) i] = detector.update(getDynamicsSettings(band), blockSize, sampleRate);
+    }
+
+    // Then the bands themselves, at their gain plus the change
+    dynamicsDesigner.clear();
+    for (int i = 0; i < numDynamic; ++i) {
+        const int band = dynamicBands[(size_t) i];
+        const auto settings = getCurrentBandSettings(band);
+        dynamicsDesigner.add(getBandType(band), sampleRate, settings.freq, settings.q,
+                             settings.gain + gainChanges[(size_t) i]);
+    }
+    dynamicsDesigner.design();
+
+    for (int i = 0; i < numDynamic; ++i) {
+        const int band = dynamicBands[(size_t) i];
+        BandDesign design;
+        design.sections[0] = dynamicsDesigner.getCoefficients(i);
+        design.svfSections[0] = dynamicsDesigner.getSvfCoefficients(i);
+        design.numSections = 1;
+        const auto lanes = getBandLanes(band);
+        setBandSections(band, design, blockSize, lanes);
+        appliedBands[(size_t) band] = design;
+        appliedLanes[(size_t) band] = lanes;
+    }
+}
+
+AudioPluginAudioProcessor::StereoMode AudioPluginAudioProcessor::getStereoMode() const {
+    // Only a stereo pair has sides to put bands on
+    if (channelLanes.getNumChannels() != 2)
+        return StereoMode::linked;
+    return (StereoMode) juce::jlimit(0, 2, juce::roundToInt(stereoParam->load()));
+}
+
+AudioPluginAudioProcessor::LaneMask AudioPluginAudioProcessor::getBandLanes(int band) const {
+    if (getStereoMode() == StereoMode::linked)
+        return BiquadCascade<FilterStateType>::allLanes;
+
+    // Channel 0 (left or mid) is lane 0 and channel 1 (right or side) lane 1
+    switch (juce::roundToInt(bandParameters[(size_t) band].channel->load())) {
+        case 1:  return 1u << 0;
+        case 2:  return 1u << 1;
+        default: return BiquadCascade<FilterStateType>::allLanes;
+    }
+}
+
+AudioPluginAudioProcessor::FilterEngine AudioPluginAudioProcessor::getFilterEngine() const {
+    return engineParam->load() > 0.5f ? FilterEngine::stateVariable : FilterEngine::biquad;
+}
+
+void AudioPluginAudioProcessor::switchFilterEngine(FilterEngine engine) {
+    // Every band is taken out of the engine being left, so it's empty when it
+    // comes back, then designed into the new one
+    for (int band = 0; band < maxBands; ++band)
+        setBandSections(band, {}, 0, BiquadCascade<FilterStateType>::allLanes);
+    activeEngine = engine;
+
+    // Every design carries both forms, so the design thread's bands move across
+    // as they are
+    if (threadedDesign)
+        for (int band = 0; band < maxBands; ++band)
+            setBandSections(band, appliedBands[(size_t) band], 0, appliedLanes[(size_t) band]);
+
+    setOversamplingOrder(oversamplingOrder);
+}
+
+FilterType AudioPluginAudioProcessor::getBandType(int band) const {
+    const int index = juce::roundToInt(bandParameters[(size_t) band].type->load());
+    return bandTypes[(size_t) juce::jlimit(0, (int) bandTypes.size() - 1, index)];
+}
+
+AudioPluginAudioProcessor::QueuedBand AudioPluginAudioProcessor::queueSmoothedBand(
+        int band, double sampleRate) {
+    const auto& smoother = smoothers[(size_t) band];
+    BandSections sections;
+    QueuedBand queued { band, batchDesigner.size(),
+                        getBandSections(band, smoother.q.getCurrentValue(), sections) };
+
+    for (int k = 0; k < queued.numSections; ++k)
+        batchDesigner.add(sections[(size_t) k].type, sampleRate,
+                          smoother.freq.getCurrentValue(),
+                          sections[(size_t) k].q,
+                          smoother.gain.getCurrentValue());
+    return queued;
+}
+
+AudioPluginAudioProcessor::BandDesign AudioPluginAudioProcessor::getDesignedBand(
+        const QueuedBand& queued) const {
+    BandDesign design;
+    design.numSections = queued.numSections;
+    for (int k = 0; k < queued.numSections; ++k) {
+        design.sections[(size_t) k] = batchDesigner.getCoefficients(queued.first + k);
+        design.svfSections[(size_t) k] = batchDesigner.getSvfCoefficients(queued.first + k);
+    }
+    return design;
+}
+
+int AudioPluginAudioProcessor::getBandSections(int band, double Q, BandSections& sections) const {
+    if (! isBandEnabled(band))
+        return 0;
+
+    const auto type = getBandType(band);
+    if (type != FilterType::highPass && type != FilterType::lowPass) {
+        sections[0] = { type, Q };
+        return 1;
+    }
+
+    const auto& params = bandParameters[(size_t) band];
+    const int slopeIndex = juce::jlimit(0, (int) passSlopes.size() - 1, juce::roundToInt(params.slope->load()));
+    const int slope = passSlopes[(size_t) slopeIndex];
+    const bool linkwitzRiley = *params.alignment > 0.5f;
+    if (slope == 12 && ! linkwitzRiley) {
+        sections[0] = { type, Q };
+        return 1;
+    }
+
+    std::array<double, maxSectionsPerBand> qs {};
+    const int numSections = getPassSectionQs(slope, linkwitzRiley, qs);
+    const auto firstOrderType = type == FilterType::highPass ? FilterType::firstOrderHighPass
+                                                             : FilterType::firstOrderLowPass;
+    for (int k = 0; k < numSections; ++k) {
+        const double q = qs[(size_t) k];
+        sections[(size_t) k] = { q > 0.0 ? type : firstOrderType, q > 0.0 ? q : 0.707 };
+    }
+    return numSections;
+}
+
+int AudioPluginAudioProcessor::getPassSectionQs(
+        int slopeDbPerOctave, bool linkwitzRiley, std::array<double, maxSectionsPerBand>& qs) {
+    int order = juce::jlimit(1, 2 * maxSectionsPerBand, slopeDbPerOctave / 6);
+    const bool twice = linkwitzRiley && order % 2 == 0;
+    if (twice)
+        order /= 2;
+
+    // Butterworth poles sit evenly around the left half of the unit circle in s.
+    // The pair at (2k - 1) pi / 2N from the imaginary axis is a section with
+    // Q = 1 / (2 sin((2k - 1) pi / 2N)), and an odd order adds a real pole, a
+    // first-order section. Lowest Q first, so the resonant sections come last
+    // and see a signal the others have already band limited.
+    int numSections = 0;
+    for (int pass = 0; pass < (twice ? 2 : 1); ++pass) {
+        if (order % 2 == 1)
+            qs[(size_t) numSections++] = 0.0;
+        for (int k = order / 2; k >= 1; --k)
+            qs[(size_t) numSections++] = 1.0 / (2.0 * std::sin((2 * k - 1) * juce::MathConstants<double>::pi
+                                                               / (2.0 * order)));
+    }
+    return numSections;
+}
+
+AudioPluginAudioProcessor::BandDesign AudioPluginAudioProcessor::designBand(
+        int band, double sampleRate, double freq, double gain, double Q) const {
+    // Past Nyquist a band is designed at Nyquist, as the batch designer does
+    freq = juce::jmin(freq, 0.5 * sampleRate);
+
+    BandSections sections;
+    BandDesign design;
+    design.numSections = getBandSections(band, Q, sections);
+    for (int k = 0; k < design.numSections; ++k) {
+        const auto& section = sections[(size_t) k];
+        design.sections[(size_t) k] = makeSection(section.type, sampleRate, freq, section.q, gain);
+        design.svfSections[(size_t) k] = makeSvf(section.type, sampleRate, freq, section.q, gain);
+    }
+    return design;
+}
+
+std::array<double,6> AudioPluginAudioProcessor::makeSection(
+        FilterType type, double sampleRate, double freq, double Q, double gain) {
+    // Using the EQ Cookbook formulas:
+    switch (type) {
+        case FilterType::highPass:           return makeHighPass(sampleRate, freq, Q);
+        case FilterType::lowPass:            return makeLowPass(sampleRate, freq, Q);
+        case FilterType::peaking:            return makePeaking(sampleRate, freq, Q, gain);
+        case FilterType::lowShelf:           return makeLowShelf(sampleRate, freq, Q, gain);
+        case FilterType::highShelf:          return makeHighShelf(sampleRate, freq, Q, gain);
+        case FilterType::bandPass:           return makeBandPass(sampleRate, freq, Q);
+        case FilterType::firstOrderHighPass: return makeFirstOrderHighPass(sampleRate, freq);
+        case FilterType::firstOrderLowPass:  return makeFirstOrderLowPass(sampleRate, freq);
     }
-    auto lowPassCoefs = makeLowPass(sampleRate, lowPassFreq, 0.707);
-    lowPassFilter.setCoefficients(lowPassCoefs[0], lowPassCoefs[1], lowPassCoefs[2],
-                                  lowPassCoefs[3], lowPassCoefs[4], lowPassCoefs[5]);
+    jassertfalse;
+    return bypassedBand;
 }
 
 std::array<double,6> AudioPluginAudioProcessor::makeLowPass(
@@ -247,6 +972,45 @@ std::array<double,6> AudioPluginAudioProcessor::makeHighPass(
     return { b0, b1, b2, a0, a1, a2 };
 }
 
+std::array<double,6> AudioPluginAudioProcessor::makeFirstOrderLowPass(
+        double sampleRate, double freq) {
+    // Bilinear transform of 1 / (s + 1), written with the half angle so it stays
+    // finite right up to Nyquist, where it becomes a straight wire
+    double halfW0 = juce::MathConstants<double>::pi * (freq / sampleRate);
+    double sh = std::sin(halfW0);
+    double ch = std::cos(halfW0);
+
+    return { sh, sh, 0.0, sh + ch, sh - ch, 0.0 };
+}
+
+std::array<double,6> AudioPluginAudioProcessor::makeFirstOrderHighPass(
+        double sampleRate, double freq) {
+    // s / (s + 1), a straight wire at 0 Hz
+    double halfW0 = juce::MathConstants<double>::pi * (freq / sampleRate);
+    double sh = std::sin(halfW0);
+    double ch = std::cos(halfW0);
+
+    return { ch, -ch, 0.0, sh + ch, sh - ch, 0.0 };
+}
+
+std::array<double,6> AudioPluginAudioProcessor::makeBandPass(
+        double sampleRate, double freq, double Q) {
+    // Constant 0 dB peak gain
+    double w0 = 2.0 * juce::MathConstants<double>::pi * (freq / sampleRate);
+    double alpha = std::sin(w0)/(2.0*Q);
+
+    double cosw0 = std::cos(w0);
+
+    double b0 =   alpha;
+    double b1 =   0.0;
+    double b2 =  -alpha;
+    double a0 =   1.0 + alpha;
+    double a1 =  -2.0*cosw0;
+    double a2 =   1.0 - alpha;
+
+    return { b0, b1, b2, a0, a1, a2 };
+}
+
 std::array<double,6> AudioPluginAudioProcessor::makePeaking(
         double sampleRate, double freq, double Q, double dBgain) {
     double A = std::pow(10.0, dBgain / 40.0);
@@ -300,9 +1064,20 @@ std::array<double,6> AudioPluginAudioProcessor::makeHighShelf(
     return {b0, b1, b2, a0, a1, a2};
 }
 
+SvfCoefficients<double> AudioPluginAudioProcessor::makeSvf(
+        FilterType type, double sampleRate, double freq, double Q, double dBgain) {
+    // The bilinear transform's prewarping, as in every design above
+    double g = std::tan(juce::MathConstants<double>::pi * juce::jlimit(0.0, 0.5, freq / sampleRate));
+    double A = std::pow(10.0, dBgain / 40.0);
+
+    return BatchDesigner::designSvf(type, std::min(g, svfMaxG), Q, A, std::sqrt(A));
+}
+
 void AudioPluginAudioProcessor::releaseResources() {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    designThread->remove(*this);
+    linearPhase.release();
 }
 
 bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
@@ -311,12 +1086,11 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout works, from mono up to 7.1.4 and beyond: every channel gets its
+    // own filter state in a SIMD lane, and all of them share one coefficient set.
+    // The default bus stays stereo, since some plugin hosts, such as certain
+    // GarageBand versions, will only load plugins that support stereo bus layouts.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -333,81 +1107,304 @@ void AudioPluginAudioProcessor::processBlock (
         juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused (midiMessages);
+    processSamples(buffer);
+}
+
+void AudioPluginAudioProcessor::processBlock (
+        juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    processSamples(buffer);
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer) {
     juce::ScopedNoDenormals noDenormals;
 
-    double sampleRate = getSampleRate();
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
 
-    double highPassFreq = *apvts.getRawParameterValue("HPFREQ");
-    double lowPassFreq = *apvts.getRawParameterValue("LPFREQ");
+    if (channelLanes.getMaxSamples() == 0)
+        return;
 
-    double bell1Freq = *apvts.getRawParameterValue("BELL1FREQ");
-    double bell1Gain = *apvts.getRawParameterValue("BELL1GAIN");
-    double bell1Q = *apvts.getRawParameterValue("BELL1Q");
+    profiler.beginBlock();
 
-    double bell2Freq = *apvts.getRawParameterValue("BELL2FREQ");
-    double bell2Gain = *apvts.getRawParameterValue("BELL2GAIN");
-    double bell2Q = *apvts.getRawParameterValue("BELL2Q");
-    
-    double bell3Freq = *apvts.getRawParameterValue("BELL3FREQ");
-    double bell3Gain = *apvts.getRawParameterValue("BELL3GAIN");
-    double bell3Q = *apvts.getRawParameterValue("BELL3Q");
+    // All channels go through the filters together, one SIMD lane each
+    const int numChannels = juce::jmin((int) totalNumInputChannels, channelLanes.getNumChannels());
+    const int numSamples = buffer.getNumSamples();
+    auto* const* channels = buffer.getArrayOfWritePointers();
 
-    bool isLowShelfMode = *apvts.getRawParameterValue("ISLOWSHELFMODE") > 0.5f;
-    bool isHighShelfMode = *apvts.getRawParameterValue("ISHIGHSHELFMODE") > 0.5f;
+    // Silence in, once the filters have rung out, is silence out: the filters
+    // sleep until the input comes back
+    bool silent = true;
+    for (int channel = 0; channel < numChannels && silent; ++channel)
+        silent = buffer.getMagnitude(channel, 0, numSamples) == (SampleType) 0;
 
-    // Using the EQ Cookbook formulas:
-    auto highPassCoefs = makeHighPass(sampleRate, highPassFreq, 0.707); // Q=0.707 as an example
-    highPassFilter.setCoefficients(highPassCoefs[0], highPassCoefs[1], highPassCoefs[2], 
-                                   highPassCoefs[3], highPassCoefs[4], highPassCoefs[5]);
-    // Choose between the Low Shelf and the bell 3
-    if (isLowShelfMode) {
-        auto lowShelfCoefs = makeLowShelf(sampleRate, bell1Freq, bell1Q, bell1Gain);
-        bell1Filter.setCoefficients(lowShelfCoefs[0], lowShelfCoefs[1], lowShelfCoefs[2],
-                                    lowShelfCoefs[3], lowShelfCoefs[4], lowShelfCoefs[5]);
+    silentSamples = silent ? silentSamples + numSamples : 0;
+    if (! silent)
+        idle = false;
+
+    analyzer.push(SpectrumAnalyzer::preTap, channels, numChannels, numSamples);
+    profiler.beginFilters();
+    if (idle)
+        skipIdleSmoothing(numSamples << oversamplingOrder);
+    else
+        processFilters(channels, numChannels, numSamples);
+    profiler.endFilters();
+    analyzer.push(SpectrumAnalyzer::postTap, channels, numChannels, numSamples);
+
+    if (silent && ! idle && (double) silentSamples >= getRunningTailSamples())
+        enterIdle();
+
+    // Smoothing goes on for as long as audio plays, one design per block
+    if (threadedDesign) {
+        samplesPlayed.fetch_add(numSamples << oversamplingOrder, std::memory_order_release);
+        if (designSmoothing.load(std::memory_order_relaxed))
+            requestDesign();
     }
-    else {
-        auto bell1Coefs = makePeaking(sampleRate, bell1Freq, bell1Q, bell1Gain);
-        bell1Filter.setCoefficients(bell1Coefs[0], bell1Coefs[1], bell1Coefs[2],
-                bell1Coefs[3], bell1Coefs[4], bell1Coefs[5]);
-    }
-    auto bell2Coefs = makePeaking(sampleRate, bell2Freq, bell2Q, bell2Gain);
-    bell2Filter.setCoefficients(bell2Coefs[0], bell2Coefs[1], bell2Coefs[2],
-                                bell2Coefs[3], bell2Coefs[4], bell2Coefs[5]);
-    // Choose between the High Shelf and the bell 3
-    if (isHighShelfMode) {
-        auto highShelfCoefs = makeHighShelf(sampleRate, bell3Freq, bell3Q, bell3Gain);
-        bell3Filter.setCoefficients(highShelfCoefs[0], highShelfCoefs[1], highShelfCoefs[2],
-                                    highShelfCoefs[3], highShelfCoefs[4], highShelfCoefs[5]);
+
+    if constexpr (DspProfiler::enabled)
+        profiler.endBlock(numSamples, getSampleRate(), idle ? 0 : countActiveBands());
+}
+
+double AudioPluginAudioProcessor::getRunningTailSamples() {
+    if (! runningTailDirty)
+        return runningTailSamples;
+
+    // The cascade's own decay is in samples at the oversampled rate. Sections
+    // that finished ramping since only decay faster, so the cached value errs
+    // on the long side.
+    const double decaySamples = linearPhaseActive ? 0.0
+                              : getCascadeDecaySamples() / (1 << oversamplingOrder);
+    runningTailSamples = computeTailSamples(decaySamples, linearPhaseActive, oversamplingOrder);
+    runningTailDirty = false;
+    return runningTailSamples;
+}
+
+double AudioPluginAudioProcessor::getCascadeDecaySamples() const {
+    return activeEngine == FilterEngine::stateVariable ? svfCascade.getDecaySamples(tailDecayDb)
+                                                       : cascade.getDecaySamples(tailDecayDb);
+}
+
+void AudioPluginAudioProcessor::enterIdle() {
+    // What's left in the filters is below tailDecayDb by now. Clearing it means
+    // the next sound starts them from silence, as if they had kept running.
+    idle = true;
+    cascade.reset();
+    svfCascade.reset();
+    linearPhase.reset();
+    for (auto& oversampler : oversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+    // Detectors would otherwise wake up remembering the level before the silence
+    detectorActive.fill(false);
+}
+
+void AudioPluginAudioProcessor::skipIdleSmoothing(int numSamples) {
+    // In realtime the design thread keeps smoothing by the samples played,
+    // silent or not. Offline the smoothers live here: keep them moving through
+    // the silence, and have every band that moved redesigned when the input
+    // comes back.
+    if (threadedDesign)
+        return;
+
+    for (int band = 0; band < maxBands; ++band) {
+        auto& smoother = smoothers[(size_t) band];
+        if (smoother.isSmoothing()) {
+            smoother.skip(numSamples);
+            bandDirty[(size_t) band] = true;
+        }
     }
-    else {
-        auto bell3Coefs = makePeaking(sampleRate, bell3Freq, bell3Q, bell3Gain);
-        bell3Filter.setCoefficients(bell3Coefs[0], bell3Coefs[1], bell3Coefs[2],
-                bell3Coefs[3], bell3Coefs[4], bell3Coefs[5]);
+}
+
+int AudioPluginAudioProcessor::countActiveBands() const {
+    // The linear-phase filter has every band that is on folded into it
+    if (! linearPhaseActive)
+        return activeEngine == FilterEngine::stateVariable ? svfCascade.getNumActiveSections()
+                                                           : cascade.getNumActiveSections();
+
+    int count = 0;
+    for (int band = 0; band < maxBands; ++band)
+        count += isBandEnabled(band) ? 1 : 0;
+    return count;
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::processFilters(
+        SampleType* const* channels, int numChannels, int numSamples) {
+    // The linear-phase engine is built on the message thread when it's turned
+    // on, and the cascade carries on until it's ready. Offline renders may have
+    // no message loop, and can afford to build it right here.
+    if (! threadedDesign)
+        linearPhase.applyPendingChange();
+
+    // Switching modes starts the other path from silence rather than from stale
+    // state. The host hears of the new delay only now, once the engine is there,
+    // so it never compensates for a delay the audio doesn't have.
+    if ((isLinearPhase() && linearPhase.isReady()) != linearPhaseActive) {
+        linearPhaseActive = ! linearPhaseActive;
+        if (linearPhaseActive) {
+            linearPhase.reset();
+        }
+        else {
+            cascade.reset();
+            svfCascade.reset();
+        }
+        setLatencySamples(computeLatencySamples(linearPhaseActive, oversamplingOrder));
+        runningTailDirty = true;
     }
-    auto lowPassCoefs = makeLowPass(sampleRate, lowPassFreq, 0.707);
-    lowPassFilter.setCoefficients(lowPassCoefs[0], lowPassCoefs[1], lowPassCoefs[2],
-                                  lowPassCoefs[3], lowPassCoefs[4], lowPassCoefs[5]);
 
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    // Convolution and the oversamplers only run in float, so with doubles those
+    // two paths go through a float copy of the block. The cascade alone takes
+    // doubles as they are.
+    if constexpr (std::is_same_v<SampleType, double>) {
+        if (linearPhaseActive || getOversamplingParamOrder() > 0) {
+            // The copy is sized in prepareToPlay; a host block longer than that
+            // goes through in pieces rather than reallocating here
+            auto* const* floats = floatBuffer.getArrayOfWritePointers();
+            const int maxChunk = floatBuffer.getNumSamples();
+            for (int start = 0; start < numSamples; start += maxChunk) {
+                const int chunk = juce::jmin(maxChunk, numSamples - start);
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    const double* in = channels[channel] + start;
+                    float* out = floats[channel];
+                    for (int n = 0; n < chunk; ++n)
+                        out[n] = (float) in[n];
+                }
 
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
+                processFilters(floats, numChannels, chunk);
+
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    const float* in = floats[channel];
+                    double* out = channels[channel] + start;
+                    for (int n = 0; n < chunk; ++n)
+                        out[n] = (double) in[n];
+                }
+            }
+            return;
+        }
+    }
+    else if (linearPhaseActive) {
+        linearPhase.process(channels, numChannels, numSamples);
+        return;
+    }
+
+    if (getFilterEngine() != activeEngine)
+        switchFilterEngine(getFilterEngine());
+    if (getOversamplingParamOrder() != oversamplingOrder)
+        setOversamplingOrder(getOversamplingParamOrder());
+
+    if constexpr (std::is_same_v<SampleType, float>) {
+        if (oversamplingOrder > 0) {
+            processOversampled(channels, numChannels, numSamples);
+            return;
+        }
+    }
+
+    processCascade(channels, numChannels, numSamples);
+}
 
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
+void AudioPluginAudioProcessor::processOversampled(
+        float* const* channels, int numChannels, int numSamples) {
+    // Up, through the cascade at the higher rate, and back down in place
+    auto& oversampler = *oversamplers[(size_t) oversamplingOrder - 1];
+    juce::dsp::AudioBlock<float> block(channels, (size_t) numChannels, (size_t) numSamples);
+    auto oversampled = oversampler.processSamplesUp(block);
+    for (int channel = 0; channel < numChannels; ++channel)
+        oversampledChannels[(size_t) channel] = oversampled.getChannelPointer((size_t) channel);
+
+    processCascade(oversampledChannels.data(), numChannels, (int) oversampled.getNumSamples());
+    oversampler.processSamplesDown(block);
+}
+
+template <typename SampleType>
+void AudioPluginAudioProcessor::processCascade(
+        SampleType* const* channels, int numChannels, int numSamples) {
+    const double sampleRate = getSampleRate() * (1 << oversamplingOrder);
+    const int subBlockSize = controlInterval << oversamplingOrder;
+
+    // After a state load the first sub-block jumps to the new settings
+    bool snap = ! threadedDesign && snapToTargets.exchange(false);
+
+    // The lanes' state means something else after switching between left/right
+    // and mid/side, so that starts from silence too
+    const bool midSide = getStereoMode() == StereoMode::midSide;
+    if (midSide != midSideActive) {
+        midSideActive = midSide;
+        cascade.reset();
+        svfCascade.reset();
+        detectorActive.fill(false);
+    }
+
+    for (int start = 0; start < numSamples; start += subBlockSize)
     {
-        float* channelData = buffer.getWritePointer(channel);
-        for (int n = 0; n < buffer.getNumSamples(); ++n)
+        const int blockSize = juce::jmin(subBlockSize, numSamples - start);
+
+        channelLanes.gather(channels, numChannels, start, blockSize, midSide);
+
+        // Control rate: bands whose parameters moved, or are still ramping, are
+        // redesigned for the end of this sub-block and interpolated across it.
+        // In realtime that design already happened on the design thread.
+        const auto designStart = profiler.now();
+        if (threadedDesign)
+            applyDesignedCoefficients(sampleRate, blockSize);
+        else
         {
-            float sample = channelData[n];
-            sample = highPassFilter.processSample(sample);
-            sample = bell1Filter.processSample(sample);
-            sample = bell2Filter.processSample(sample);
-            sample = bell3Filter.processSample(sample);
-            sample = lowPassFilter.processSample(sample);
-            channelData[n] = sample;
+            batchDesigner.clear();
+            std::array<QueuedBand, maxBands> queuedBands {};
+            int numQueued = 0;
+            for (int band = 0; band < maxBands; ++band)
+            {
+                const bool changed = bandDirty[(size_t) band].exchange(false) || snap;
+                if (changed)
+                    updateSmootherTargets(band, snap);
+
+                auto& smoother = smoothers[(size_t) band];
+                if (changed || smoother.isSmoothing())
+                {
+                    smoother.skip(blockSize);
+                    if (isBandDynamic(band))
+                        continue;
+
+                    queuedBands[(size_t) numQueued++] = queueSmoothedBand(band, sampleRate);
+                }
+            }
+
+            batchDesigner.design();
+            for (int i = 0; i < numQueued; ++i)
+            {
+                const auto& queued = queuedBands[(size_t) i];
+                setBandSections(queued.band, getDesignedBand(queued), blockSize, getBandLanes(queued.band));
+            }
         }
-    }}
+
+        // Dynamic bands listen to this sub-block before it is filtered
+        processDynamics(sampleRate, blockSize);
+        profiler.addDesignTime(designStart);
+
+        // Bands sitting at an identity setting (0 dB, HP at 0 Hz, LP at Nyquist)
+        // aren't in the cascade at all
+        if (activeEngine == FilterEngine::stateVariable) {
+            for (int group = 0; group < channelLanes.getNumGroups(); ++group)
+                svfCascade.process(channelLanes.getGroup(group), blockSize, group);
+        }
+        else {
+            for (int group = 0; group < channelLanes.getNumGroups(); ++group)
+                cascade.process(channelLanes.getGroup(group), blockSize, group);
+        }
+
+        channelLanes.scatter(channels, numChannels, start, blockSize, midSide);
+        if (activeEngine == FilterEngine::stateVariable)
+            svfCascade.commitRamps();
+        else
+            cascade.commitRamps();
+        snap = false;
+    }
+}
 
 //==============================================================================
 bool AudioPluginAudioProcessor::hasEditor() const
@@ -423,17 +1420,52 @@ juce::AudioProcessorEditor* AudioPluginAudioProcessor::createEditor()
 //==============================================================================
 void AudioPluginAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    juce::ignoreUnused (destData);
+    std::vector<BinaryState::Entry> entries;
+    entries.reserve(stateSlots.size());
+    for (const auto& slot : stateSlots)
+        entries.push_back({ slot.idHash, slot.parameter->convertFrom0to1(slot.parameter->getValue()) });
+
+    BinaryState::write(entries, destData);
 }
 
 void AudioPluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-    juce::ignoreUnused (data, sizeInBytes);
+    if (sizeInBytes <= 0 || ! BinaryState::read(data, (size_t) sizeInBytes, stateEntries))
+        return;
+
+    // While the parameters are set, parameterChanged only marks the bands
+    loadingState = true;
+    for (size_t i = 0; i < stateEntries.size(); ++i) {
+        const auto& entry = stateEntries[i];
+
+        // States written by this version line up with the parameters one to one
+        juce::RangedAudioParameter* param = nullptr;
+        if (i < stateSlots.size() && stateSlots[i].idHash == entry.idHash) {
+            param = stateSlots[i].parameter;
+        }
+        else {
+            const auto slot = std::lower_bound(stateSlotsByHash.begin(), stateSlotsByHash.end(), entry.idHash,
+                                               [](const StateSlot& s, juce::uint32 hash) { return s.idHash < hash; });
+            if (slot == stateSlotsByHash.end() || slot->idHash != entry.idHash)
+                continue;
+            param = slot->parameter;
+        }
+
+        // Parameters already at their value cost nothing, which is most of them
+        // for a preset touching a few bands
+        const float value = param->convertTo0to1(entry.value);
+        if (value != param->getValue())
+            param->setValueNotifyingHost(value);
+    }
+    loadingState = false;
+
+    // Then every band that moved is designed once, and the linear-phase kernel
+    // rebuilt once
+    snapToTargets = true;
+    if (threadedDesign)
+        requestDesign();
+    if (isLinearPhase())
+        linearPhase.requestUpdate();
 }
 
 //==============================================================================
@@ -0,0 +1,93 @@
+#include "ParametricEqualizer100/PresetBank.h"
+
+bool PresetBank::write(const juce::File& file, const std::vector<Preset>& presets) {
+    juce::MemoryOutputStream out;
+    const auto put = [&out](size_t v) { out.writeInt((int) (juce::uint32) v); };
+
+    put(magic);
+    put(currentVersion);
+    put(presets.size());
+
+    // Names, then states, after the index
+    size_t offset = headerSize + presets.size() * indexEntrySize;
+    std::vector<size_t> nameOffsets, stateOffsets;
+    for (const auto& preset : presets) {
+        nameOffsets.push_back(offset);
+        offset += preset.name.getNumBytesAsUTF8();
+    }
+    for (const auto& preset : presets) {
+        stateOffsets.push_back(offset);
+        offset += preset.state.getSize();
+    }
+
+    for (size_t i = 0; i < presets.size(); ++i) {
+        put(nameOffsets[i]);
+        put(presets[i].name.getNumBytesAsUTF8());
+        put(stateOffsets[i]);
+        put(presets[i].state.getSize());
+    }
+    for (const auto& preset : presets)
+        out.write(preset.name.toRawUTF8(), preset.name.getNumBytesAsUTF8());
+    for (const auto& preset : presets)
+        out.write(preset.state.getData(), preset.state.getSize());
+
+    return file.replaceWithData(out.getData(), out.getDataSize());
+}
+
+bool PresetBank::open(const juce::File& file) {
+    close();
+
+    mapping = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    const auto size = mapping->getSize();
+    data = static_cast<const char*>(mapping->getData());
+
+    const auto fail = [this] {
+        close();
+        return false;
+    };
+
+    if (data == nullptr || size < headerSize)
+        return fail();
+
+    const auto count = (size_t) juce::ByteOrder::littleEndianInt(data + 8);
+    if (juce::ByteOrder::littleEndianInt(data) != magic
+            || juce::ByteOrder::littleEndianInt(data + 4) != currentVersion
+            || count > (size - headerSize) / indexEntrySize)
+        return fail();
+
+    // Every range in the index has to lie inside the file, so the getters can
+    // trust it without checking again
+    numPresets = (int) count;
+    for (int i = 0; i < numPresets; ++i)
+        for (int field : { 0, 2 })
+            if ((juce::uint64) readIndex(i, field) + readIndex(i, field + 1) > size)
+                return fail();
+
+    return true;
+}
+
+void PresetBank::close() {
+    mapping.reset();
+    data = nullptr;
+    numPresets = 0;
+}
+
+juce::uint32 PresetBank::readIndex(int index, int field) const {
+    return juce::ByteOrder::littleEndianInt(data + headerSize + (size_t) index * indexEntrySize
+                                            + (size_t) field * 4);
+}
+
+juce::String PresetBank::getPresetName(int index) const {
+    if (! juce::isPositiveAndBelow(index, numPresets))
+        return {};
+    return juce::String::fromUTF8(data + readIndex(index, 0), (int) readIndex(index, 1));
+}
+
+const void* PresetBank::getPresetState(int index, size_t& size) const {
+    if (! juce::isPositiveAndBelow(index, numPresets)) {
+        size = 0;
+        return nullptr;
+    }
+    size = readIndex(index, 3);
+    return data + readIndex(index, 2);
+}
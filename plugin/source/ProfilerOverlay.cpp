@@ -0,0 +1,35 @@
+#include "ParametricEqualizer100/ProfilerOverlay.h"
+
+ProfilerOverlay::ProfilerOverlay(DspProfiler& profilerToUse)
+    : profiler(profilerToUse) {
+    setMouseCursor(juce::MouseCursor::PointingHandCursor);
+    timerCallback();
+    startTimerHz(refreshRateHz);
+}
+
+ProfilerOverlay::~ProfilerOverlay() {
+    stopTimer();
+}
+
+void ProfilerOverlay::paint(juce::Graphics& g) {
+    g.setColour(juce::Colours::black.withAlpha(0.6f));
+    g.fillRoundedRectangle(getLocalBounds().toFloat(), 4.0f);
+
+    g.setColour(juce::Colours::white.withAlpha(0.8f));
+    g.setFont(juce::FontOptions(juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
+
+    auto area = getLocalBounds().reduced(6, 4);
+    const int lineHeight = area.getHeight() / juce::jmax(1, lines.size());
+    for (const auto& line : lines)
+        g.drawText(line, area.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+}
+
+void ProfilerOverlay::mouseDown(const juce::MouseEvent&) {
+    profiler.reset();
+}
+
+void ProfilerOverlay::timerCallback() {
+    lines.clearQuick();
+    lines.addLines(DspProfiler::toString(profiler.getStatistics()).trimEnd());
+    repaint();
+}
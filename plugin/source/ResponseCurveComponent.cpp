@@ -0,0 +1,59 @@
+#include "ParametricEqualizer100/ResponseCurveComponent.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+
+ResponseCurveComponent::ResponseCurveComponent(AudioPluginAudioProcessor& p)
+    : processorRef(p) {
+    setInterceptsMouseClicks(false, false);
+    startTimerHz(refreshRateHz);
+}
+
+void ResponseCurveComponent::paint(juce::Graphics& g) {
+    // Transparent, so the spectrum behind it shows through
+    const auto bounds = getLocalBounds().toFloat();
+
+    // Grid: every 12 dB, and 100 Hz, 1 kHz, 10 kHz on the log axis
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+    for (float db = -rangeDb; db <= rangeDb; db += 12.0f) {
+        const float y = juce::jmap(db, -rangeDb, rangeDb, bounds.getBottom(), bounds.getY());
+        g.drawHorizontalLine(juce::roundToInt(y), bounds.getX(), bounds.getRight());
+    }
+    for (float freq : { 100.0f, 1000.0f, 10000.0f }) {
+        const float x = bounds.getWidth() * std::log(freq / 20.0f) / std::log(1000.0f);
+        g.drawVerticalLine(juce::roundToInt(x), bounds.getY(), bounds.getBottom());
+    }
+
+    g.setColour(juce::Colours::orange);
+    g.strokePath(magnitudePath, juce::PathStrokeType(2.0f));
+}
+
+void ResponseCurveComponent::resized() {
+    rebuildPath();
+}
+
+void ResponseCurveComponent::timerCallback() {
+    const auto& curve = processorRef.getFrequencyResponse(juce::jmax(2, getWidth()));
+    if (curve.version != drawnVersion || getWidth() != drawnWidth)
+        rebuildPath();
+}
+
+void ResponseCurveComponent::rebuildPath() {
+    // One point per pixel; the grid is log-spaced, so the points are evenly spaced in x
+    const auto& curve = processorRef.getFrequencyResponse(juce::jmax(2, getWidth()));
+    const auto bounds = getLocalBounds().toFloat();
+    const auto numPoints = curve.magnitudeDb.size();
+
+    magnitudePath.clear();
+    for (size_t i = 0; i < numPoints; ++i) {
+        const float x = bounds.getX() + bounds.getWidth() * (float) i / (float) (numPoints - 1);
+        const float db = juce::jlimit(-rangeDb, rangeDb, curve.magnitudeDb[i]);
+        const float y = juce::jmap(db, -rangeDb, rangeDb, bounds.getBottom(), bounds.getY());
+        if (i == 0)
+            magnitudePath.startNewSubPath(x, y);
+        else
+            magnitudePath.lineTo(x, y);
+    }
+
+    drawnVersion = curve.version;
+    drawnWidth = getWidth();
+    repaint();
+}
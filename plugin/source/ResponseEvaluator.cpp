@@ -0,0 +1,120 @@
+#include "ParametricEqualizer100/ResponseEvaluator.h"
+#include <algorithm>
+#include <cmath>
+
+bool ResponseEvaluator::setGrid(int numPoints, double sampleRateToUse,
+                                double minFrequencyToUse, double maxFrequencyToUse) {
+    numPoints = std::max(2, numPoints);
+    if (numPoints == getNumPoints() && sampleRateToUse == sampleRate
+        && minFrequencyToUse == minFrequency && maxFrequencyToUse == maxFrequency)
+        return false;
+
+    sampleRate = sampleRateToUse;
+    minFrequency = minFrequencyToUse;
+    maxFrequency = maxFrequencyToUse;
+
+    const auto n = (size_t) numPoints;
+    curve.frequencies.resize(n);
+    for (auto* table : { &cosw, &sinw, &cos2w, &sin2w })
+        table->resize(n);
+
+    const double pi = 3.14159265358979323846;
+    const double ratio = std::log(maxFrequency / minFrequency);
+    for (size_t i = 0; i < n; ++i) {
+        const double f = minFrequency * std::exp(ratio * (double) i / (double) (n - 1));
+        const double w = 2.0 * pi * std::min(f, 0.5 * sampleRate) / sampleRate;
+        curve.frequencies[i] = (float) f;
+        cosw[i] = std::cos(w);
+        sinw[i] = std::sin(w);
+        cos2w[i] = std::cos(2.0 * w);
+        sin2w[i] = std::sin(2.0 * w);
+    }
+
+    for (auto& band : bands)
+        band.valid = false;
+    return true;
+}
+
+void ResponseEvaluator::setNumBands(int numBands) {
+    if ((size_t) numBands != bands.size())
+        bands.assign((size_t) numBands, Band{});
+}
+
+void ResponseEvaluator::setBand(int index, const std::array<double,6>* sections, int numSections) {
+    auto& band = bands[(size_t) index];
+    if (band.valid && std::equal(sections, sections + numSections, band.sections.begin(), band.sections.end()))
+        return;
+    band.sections.assign(sections, sections + numSections);
+    band.valid = false;
+}
+
+bool ResponseEvaluator::update(const std::vector<std::array<double,6>>& newBands) {
+    setNumBands((int) newBands.size());
+    for (size_t b = 0; b < newBands.size(); ++b)
+        setBand((int) b, &newBands[b], 1);
+    return update();
+}
+
+bool ResponseEvaluator::update() {
+    bool changed = false;
+    for (auto& band : bands) {
+        if (band.valid)
+            continue;
+        evaluateBand(band);
+        band.valid = true;
+        changed = true;
+    }
+
+    if (changed || curve.magnitudeDb.size() != curve.frequencies.size()) {
+        sumBands();
+        ++curve.version;
+        changed = true;
+    }
+    return changed;
+}
+
+void ResponseEvaluator::evaluateBand(Band& band) const {
+    const auto n = cosw.size();
+    band.magnitudeDb.assign(n, 0.0f);
+    band.phaseRadians.assign(n, 0.0f);
+
+    for (const auto& c : band.sections)
+        addSection(band, c);
+}
+
+void ResponseEvaluator::addSection(Band& band, const std::array<double,6>& c) const {
+    const auto n = cosw.size();
+    const double inv = 1.0 / c[3];
+    const double b0 = c[0] * inv, b1 = c[1] * inv, b2 = c[2] * inv;
+    const double a1 = c[4] * inv, a2 = c[5] * inv;
+
+    // H(e^jw) = (b0 + b1 e^-jw + b2 e^-2jw) / (1 + a1 e^-jw + a2 e^-2jw)
+    for (size_t i = 0; i < n; ++i) {
+        const double nr = b0 + b1 * cosw[i] + b2 * cos2w[i];
+        const double ni = -(b1 * sinw[i] + b2 * sin2w[i]);
+        const double dr = 1.0 + a1 * cosw[i] + a2 * cos2w[i];
+        const double di = -(a1 * sinw[i] + a2 * sin2w[i]);
+
+        // 10 log10 of the power ratio, floored so a zero on the grid stays finite
+        const double power = (nr * nr + ni * ni) / (dr * dr + di * di);
+        band.magnitudeDb[i] += (float) (10.0 * std::log10(std::max(power, 1.0e-30)));
+        band.phaseRadians[i] += (float) (std::atan2(ni, nr) - std::atan2(di, dr));
+    }
+}
+
+void ResponseEvaluator::sumBands() {
+    const auto n = curve.frequencies.size();
+    curve.magnitudeDb.assign(n, 0.0f);
+    curve.phaseRadians.assign(n, 0.0f);
+
+    for (const auto& band : bands) {
+        for (size_t i = 0; i < n; ++i) {
+            curve.magnitudeDb[i] += band.magnitudeDb[i];
+            curve.phaseRadians[i] += band.phaseRadians[i];
+        }
+    }
+
+    const float twoPi = 6.28318530717958647692f;
+    for (auto& phase : curve.phaseRadians)
+        phase = std::remainder(phase, twoPi);
+}
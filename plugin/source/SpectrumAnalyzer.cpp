@@ -0,0 +1,155 @@
+#include "ParametricEqualizer100/SpectrumAnalyzer.h"
+
+SpectrumAnalyzer::SpectrumAnalyzer() : juce::Thread("Spectrum analyzer") {
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(
+            window.data(), window.size(), juce::dsp::WindowingFunction<float>::hann, false);
+
+    // A full-scale sine lands at 0 dB
+    float sum = 0.0f;
+    for (float w : window)
+        sum += w;
+    windowGain = 2.0f / sum;
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+    stopThread(1000);
+}
+
+void SpectrumAnalyzer::prepare(double sampleRateToUse) {
+    const bool wasRunning = isThreadRunning();
+    stopThread(1000);
+
+    sampleRate = sampleRateToUse;
+    const juce::ScopedLock lock(frameLock);
+    for (auto& tap : taps) {
+        tap.fifo.reset();
+        std::fill(tap.history.begin(), tap.history.end(), 0.0f);
+        std::fill(tap.averageDb.begin(), tap.averageDb.end(), floorDb);
+        std::fill(tap.peakDb.begin(), tap.peakDb.end(), floorDb);
+        tap.published.sampleRate = sampleRate;
+    }
+
+    if (wasRunning)
+        startThread(juce::Thread::Priority::low);
+}
+
+void SpectrumAnalyzer::setEnabled(bool shouldBeEnabled) {
+    if (shouldBeEnabled == isEnabled())
+        return;
+
+    if (shouldBeEnabled) {
+        enabled = true;
+        startThread(juce::Thread::Priority::low);
+    }
+    else {
+        enabled = false;
+        stopThread(1000);
+    }
+}
+
+void SpectrumAnalyzer::push(Tap tap, const float* const* channels,
+                            int numChannels, int numSamples) noexcept {
+    pushSamples(tap, channels, numChannels, numSamples);
+}
+
+void SpectrumAnalyzer::push(Tap tap, const double* const* channels,
+                            int numChannels, int numSamples) noexcept {
+    pushSamples(tap, channels, numChannels, numSamples);
+}
+
+template <typename SampleType>
+void SpectrumAnalyzer::pushSamples(Tap tap, const SampleType* const* channels,
+                                   int numChannels, int numSamples) noexcept {
+    if (! isEnabled() || numChannels == 0)
+        return;
+
+    auto& state = taps[(size_t) tap];
+    int start1, size1, start2, size2;
+    state.fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    // Mono mix straight into the FIFO's free space
+    const float gain = 1.0f / (float) numChannels;
+    const auto mix = [&](int fifoStart, int size, int offset) {
+        float* dst = state.fifoData.data() + fifoStart;
+        if constexpr (std::is_same_v<SampleType, float>) {
+            juce::FloatVectorOperations::copyWithMultiply(dst, channels[0] + offset, gain, size);
+            for (int channel = 1; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::addWithMultiply(dst, channels[channel] + offset, gain, size);
+        }
+        else {
+            for (int n = 0; n < size; ++n) {
+                SampleType sum = 0;
+                for (int channel = 0; channel < numChannels; ++channel)
+                    sum += channels[channel][offset + n];
+                dst[n] = (float) sum * gain;
+            }
+        }
+    };
+    if (size1 > 0)
+        mix(start1, size1, 0);
+    if (size2 > 0)
+        mix(start2, size2, size1);
+
+    state.fifo.finishedWrite(size1 + size2);
+}
+
+bool SpectrumAnalyzer::getFrame(Tap tap, Frame& frame) const {
+    const juce::ScopedLock lock(frameLock);
+    const auto& published = taps[(size_t) tap].published;
+    if (published.version == frame.version && ! frame.averageDb.empty())
+        return false;
+
+    frame = published;
+    return true;
+}
+
+void SpectrumAnalyzer::run() {
+    while (! threadShouldExit()) {
+        for (int tap = 0; tap < numTaps; ++tap)
+            drain(tap);
+        wait(1000 / displayRateHz);
+    }
+}
+
+void SpectrumAnalyzer::drain(int tap) {
+    auto& state = taps[(size_t) tap];
+    bool analysed = false;
+
+    while (state.fifo.getNumReady() >= hopSize) {
+        // Slide the history along by one hop and append the new samples
+        std::copy(state.history.begin() + hopSize, state.history.end(), state.history.begin());
+        float* dst = state.history.data() + (fftSize - hopSize);
+
+        int start1, size1, start2, size2;
+        state.fifo.prepareToRead(hopSize, start1, size1, start2, size2);
+        std::copy_n(state.fifoData.data() + start1, size1, dst);
+        std::copy_n(state.fifoData.data() + start2, size2, dst + size1);
+        state.fifo.finishedRead(size1 + size2);
+
+        analyseFrame(tap);
+        analysed = true;
+    }
+
+    if (analysed) {
+        const juce::ScopedLock lock(frameLock);
+        state.published.averageDb = state.averageDb;
+        state.published.peakDb = state.peakDb;
+        state.published.sampleRate = sampleRate;
+        ++state.published.version;
+    }
+}
+
+void SpectrumAnalyzer::analyseFrame(int tap) {
+    auto& state = taps[(size_t) tap];
+
+    juce::FloatVectorOperations::multiply(fftData.data(), state.history.data(), window.data(), fftSize);
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+    fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    for (size_t bin = 0; bin < (size_t) numBins; ++bin) {
+        const float db = juce::Decibels::gainToDecibels(fftData[bin] * windowGain, floorDb);
+        auto& average = state.averageDb[bin];
+        average += (db - average) * averagingCoefficient;
+        state.peakDb[bin] = juce::jmax(db, state.peakDb[bin] - peakDecayDb);
+    }
+}
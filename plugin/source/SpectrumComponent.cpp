@@ -0,0 +1,83 @@
+#include "ParametricEqualizer100/SpectrumComponent.h"
+
+SpectrumComponent::SpectrumComponent(SpectrumAnalyzer& analyzerToUse)
+    : analyzer(analyzerToUse) {
+    setInterceptsMouseClicks(false, false);
+    analyzer.setEnabled(true);
+    startTimerHz(refreshRateHz);
+}
+
+SpectrumComponent::~SpectrumComponent() {
+    stopTimer();
+    analyzer.setEnabled(false);
+}
+
+void SpectrumComponent::paint(juce::Graphics& g) {
+    g.setColour(juce::Colours::black.withAlpha(0.3f));
+    g.fillRect(getLocalBounds());
+
+    g.setColour(juce::Colours::lightblue.withAlpha(0.2f));
+    g.fillPath(prePath);
+
+    g.setColour(juce::Colours::lightblue.withAlpha(0.7f));
+    g.strokePath(postPath, juce::PathStrokeType(1.0f));
+
+    g.setColour(juce::Colours::white.withAlpha(0.3f));
+    g.strokePath(peakPath, juce::PathStrokeType(1.0f));
+}
+
+void SpectrumComponent::resized() {
+    rebuildPaths();
+}
+
+void SpectrumComponent::timerCallback() {
+    const bool preChanged = analyzer.getFrame(SpectrumAnalyzer::preTap, preFrame);
+    const bool postChanged = analyzer.getFrame(SpectrumAnalyzer::postTap, postFrame);
+    if (preChanged || postChanged)
+        rebuildPaths();
+}
+
+void SpectrumComponent::rebuildPaths() {
+    prePath = makePath(preFrame.averageDb, preFrame.sampleRate, true);
+    postPath = makePath(postFrame.averageDb, postFrame.sampleRate, false);
+    peakPath = makePath(postFrame.peakDb, postFrame.sampleRate, false);
+    repaint();
+}
+
+juce::Path SpectrumComponent::makePath(const std::vector<float>& db, double sampleRate, bool closed) const {
+    juce::Path path;
+    const auto bounds = getLocalBounds().toFloat();
+    if (db.empty() || sampleRate <= 0.0 || bounds.isEmpty())
+        return path;
+
+    // One point per pixel column, reading the bin under it. The log axis puts
+    // many bins under a pixel up high; the loudest of them is what shows.
+    const int width = getWidth();
+    const double binsPerHz = SpectrumAnalyzer::fftSize / sampleRate;
+    const auto frequencyAt = [width](double x) { return 20.0 * std::pow(1000.0, x / width); };
+
+    for (int x = 0; x < width; ++x) {
+        const int firstBin = juce::jlimit(1, (int) db.size() - 1, (int) (frequencyAt(x) * binsPerHz));
+        const int lastBin = juce::jlimit(firstBin, (int) db.size() - 1, (int) (frequencyAt(x + 1) * binsPerHz));
+        float level = db[(size_t) firstBin];
+        for (int bin = firstBin + 1; bin <= lastBin; ++bin)
+            level = juce::jmax(level, db[(size_t) bin]);
+
+        const float y = juce::jmap(juce::jlimit(minDb, maxDb, level), minDb, maxDb,
+                                   bounds.getBottom(), bounds.getY());
+        if (x > 0)
+            path.lineTo(bounds.getX() + (float) x, y);
+        else if (closed) {
+            path.startNewSubPath(bounds.getX(), bounds.getBottom());
+            path.lineTo(bounds.getX(), y);
+        }
+        else
+            path.startNewSubPath(bounds.getX(), y);
+    }
+
+    if (closed) {
+        path.lineTo(bounds.getRight(), bounds.getBottom());
+        path.closeSubPath();
+    }
+    return path;
+}
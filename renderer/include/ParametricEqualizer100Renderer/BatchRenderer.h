@@ -0,0 +1,51 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <utility>
+#include <vector>
+
+// Offline renderer: runs the EQ over a list of audio files on a thread pool, one
+// file per worker. Files are streamed through in fixed-size chunks, so memory use
+// doesn't depend on how long they are.
+class BatchRenderer {
+public:
+    struct Settings {
+        // Parameter ID and plain (unnormalised) value, e.g. { "BAND1FREQ", 80.0f }
+        std::vector<std::pair<juce::String, float>> parameters;
+
+        // Where rendered files go. Empty means next to each input file.
+        juce::File outputDirectory;
+
+        int blockSize = 4096;
+        int numThreads = juce::SystemStats::getNumCpus();
+    };
+
+    struct Result {
+        juce::File input, output;
+        bool succeeded = false;
+        juce::String error;
+
+        double audioSeconds = 0.0;   // length of the file
+        double renderSeconds = 0.0;  // wall clock, reading and writing included
+        double dspSeconds = 0.0;     // time spent inside processBlock only
+
+        // The processor's DspProfiler statistics, when profiling is built in
+        juce::String profile;
+
+        double getRealtimeMultiple() const;
+        double getDspRealtimeMultiple() const;
+    };
+
+    explicit BatchRenderer(Settings settingsToUse);
+
+    // Renders every file and returns one result per file, in the same order.
+    std::vector<Result> render(const juce::Array<juce::File>& files) const;
+
+    juce::File getOutputFileFor(const juce::File& input) const;
+
+    static Result renderFile(const juce::File& input, const juce::File& output,
+                             const Settings& settings);
+
+private:
+    Settings settings;
+};
@@ -0,0 +1,173 @@
+#include "ParametricEqualizer100Renderer/BatchRenderer.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+
+namespace {
+
+// Renders one file into its slot of the results array
+class RenderJob final : public juce::ThreadPoolJob {
+public:
+    RenderJob(juce::File inputToUse, juce::File outputToUse,
+              const BatchRenderer::Settings& settingsToUse, BatchRenderer::Result& resultToFill)
+        : juce::ThreadPoolJob(inputToUse.getFileName()),
+          input(std::move(inputToUse)), output(std::move(outputToUse)),
+          settings(settingsToUse), result(resultToFill) {
+    }
+
+    JobStatus runJob() override {
+        result = BatchRenderer::renderFile(input, output, settings);
+        return jobHasFinished;
+    }
+
+private:
+    juce::File input, output;
+    const BatchRenderer::Settings& settings;
+    BatchRenderer::Result& result;
+};
+
+juce::AudioChannelSet channelSetFor(int numChannels) {
+    auto set = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    return set.isDisabled() ? juce::AudioChannelSet::discreteChannels(numChannels) : set;
+}
+
+} // namespace
+
+//==============================================================================
+double BatchRenderer::Result::getRealtimeMultiple() const {
+    return renderSeconds > 0.0 ? audioSeconds / renderSeconds : 0.0;
+}
+
+double BatchRenderer::Result::getDspRealtimeMultiple() const {
+    return dspSeconds > 0.0 ? audioSeconds / dspSeconds : 0.0;
+}
+
+//==============================================================================
+BatchRenderer::BatchRenderer(Settings settingsToUse)
+    : settings(std::move(settingsToUse)) {
+    settings.blockSize = juce::jmax(1, settings.blockSize);
+    settings.numThreads = juce::jmax(1, settings.numThreads);
+}
+
+juce::File BatchRenderer::getOutputFileFor(const juce::File& input) const {
+    const auto name = input.getFileNameWithoutExtension() + "_eq" + input.getFileExtension();
+    const auto directory = settings.outputDirectory == juce::File()
+                         ? input.getParentDirectory()
+                         : settings.outputDirectory;
+    return directory.getChildFile(name);
+}
+
+std::vector<BatchRenderer::Result> BatchRenderer::render(const juce::Array<juce::File>& files) const {
+    std::vector<Result> results((size_t) files.size());
+
+    juce::ThreadPool pool(settings.numThreads);
+    for (int i = 0; i < files.size(); ++i)
+        pool.addJob(new RenderJob(files[i], getOutputFileFor(files[i]), settings,
+                                  results[(size_t) i]),
+                    true);
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep(10);
+
+    return results;
+}
+
+BatchRenderer::Result BatchRenderer::renderFile(
+        const juce::File& input, const juce::File& output, const Settings& settings) {
+    Result result;
+    result.input = input;
+    result.output = output;
+
+    const auto fail = [&result](const juce::String& message) {
+        result.error = message;
+        return result;
+    };
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(input));
+    if (reader == nullptr)
+        return fail("can't open " + input.getFullPathName() + " as audio");
+
+    const int numChannels = (int) reader->numChannels;
+    const double sampleRate = reader->sampleRate;
+
+    auto* format = formats.findFormatForFileExtension(output.getFileExtension());
+    if (format == nullptr)
+        return fail("no audio format for " + output.getFileName());
+
+    // FileOutputStream appends, so start from an empty file
+    output.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream = output.createOutputStream();
+    if (stream == nullptr)
+        return fail("can't write to " + output.getFullPathName());
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(
+            stream.get(), sampleRate, (unsigned int) numChannels,
+            (int) reader->bitsPerSample, reader->metadataValues, 0));
+    if (writer == nullptr)
+        return fail("can't create a " + format->getFormatName() + " writer for "
+                    + output.getFileName());
+    stream.release(); // the writer owns it now
+
+    // One processor per file, set up exactly like a host would
+    AudioPluginAudioProcessor processor;
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSetFor(numChannels));
+    layout.outputBuses.add(channelSetFor(numChannels));
+    if (! processor.setBusesLayout(layout))
+        return fail(juce::String(numChannels) + " channels isn't a supported layout");
+
+    // Parameters go in before prepareToPlay so nothing ramps from the defaults
+    auto& apvts = processor.getValueTreeState();
+    for (const auto& [id, value] : settings.parameters) {
+        auto* param = apvts.getParameter(id);
+        if (param == nullptr)
+            return fail("unknown parameter " + id);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+    processor.prepareToPlay(sampleRate, settings.blockSize);
+
+    juce::AudioBuffer<float> buffer(numChannels, settings.blockSize);
+    juce::MidiBuffer midi;
+    juce::int64 dspTicks = 0;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    // Latency (linear phase) is trimmed off the front, and flushed out of the back
+    // by reading on past the end, where the reader pads with silence
+    juce::int64 samplesToSkip = processor.getLatencySamples();
+    const juce::int64 lengthToRender = reader->lengthInSamples + samplesToSkip;
+
+    for (juce::int64 position = 0; position < lengthToRender; position += settings.blockSize) {
+        const int numSamples = (int) juce::jmin((juce::int64) settings.blockSize,
+                                                lengthToRender - position);
+        buffer.setSize(numChannels, numSamples, false, false, true);
+        reader->read(&buffer, 0, numSamples, position, true, true);
+
+        const auto blockStart = juce::Time::getHighResolutionTicks();
+        processor.processBlock(buffer, midi);
+        dspTicks += juce::Time::getHighResolutionTicks() - blockStart;
+
+        const int skipped = (int) juce::jmin(samplesToSkip, (juce::int64) numSamples);
+        samplesToSkip -= skipped;
+        if (skipped < numSamples
+            && ! writer->writeFromAudioSampleBuffer(buffer, skipped, numSamples - skipped))
+            return fail("write failed for " + output.getFullPathName());
+    }
+
+    if constexpr (DspProfiler::enabled)
+        result.profile = DspProfiler::toString(processor.getProfiler().getStatistics());
+
+    processor.releaseResources();
+    writer.reset(); // flushes the file
+
+    result.audioSeconds = (double) reader->lengthInSamples / sampleRate;
+    result.renderSeconds = juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - startTicks);
+    result.dspSeconds = juce::Time::highResolutionTicksToSeconds(dspTicks);
+    result.succeeded = true;
+    return result;
+}
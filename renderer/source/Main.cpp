@@ -0,0 +1,107 @@
+#include "ParametricEqualizer100Renderer/BatchRenderer.h"
+#include <juce_events/juce_events.h>
+#include <iostream>
+
+namespace {
+
+void printUsage() {
+    std::cout
+        << "Usage: ParametricEqualizer100Renderer [options] <file>...\n"
+        << "\n"
+        << "Renders WAV/AIFF files through the EQ, one file per worker thread.\n"
+        << "\n"
+        << "Options:\n"
+        << "  --set <ID>=<value>   Set a parameter to a plain value, e.g. --set BAND1FREQ=80\n"
+        << "  --out <directory>    Write results here (default: next to each input)\n"
+        << "  --threads <n>        Worker threads (default: number of CPUs)\n"
+        << "  --block <samples>    Chunk size for streaming (default: 4096)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    BatchRenderer::Settings settings;
+    juce::Array<juce::File> files;
+
+    for (int i = 1; i < argc; ++i) {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--set" && hasValue) {
+            const juce::String assignment(argv[++i]);
+            if (! assignment.contains("=")) {
+                std::cerr << "Expected <ID>=<value>, got " << assignment << "\n";
+                return 1;
+            }
+            settings.parameters.emplace_back(assignment.upToFirstOccurrenceOf("=", false, false),
+                                             assignment.fromFirstOccurrenceOf("=", false, false)
+                                                       .getFloatValue());
+        }
+        else if (arg == "--out" && hasValue) {
+            settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(argv[++i]);
+            settings.outputDirectory.createDirectory();
+        }
+        else if (arg == "--threads" && hasValue) {
+            settings.numThreads = juce::String(argv[++i]).getIntValue();
+        }
+        else if (arg == "--block" && hasValue) {
+            settings.blockSize = juce::String(argv[++i]).getIntValue();
+        }
+        else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        else if (arg.startsWith("--")) {
+            std::cerr << "Unknown or incomplete option " << arg << "\n\n";
+            printUsage();
+            return 1;
+        }
+        else {
+            files.add(juce::File::getCurrentWorkingDirectory().getChildFile(arg));
+        }
+    }
+
+    if (files.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    settings.numThreads = juce::jmax(1, settings.numThreads);
+    BatchRenderer renderer(settings);
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const auto results = renderer.render(files);
+    const double wallSeconds = juce::Time::highResolutionTicksToSeconds(
+            juce::Time::getHighResolutionTicks() - startTicks);
+
+    double totalAudioSeconds = 0.0;
+    int numFailed = 0;
+
+    for (const auto& result : results) {
+        if (! result.succeeded) {
+            std::cerr << result.input.getFileName() << ": " << result.error << "\n";
+            ++numFailed;
+            continue;
+        }
+
+        totalAudioSeconds += result.audioSeconds;
+        std::cout << result.input.getFileName() << " -> " << result.output.getFileName()
+                  << ": " << juce::String(result.audioSeconds, 2) << " s audio in "
+                  << juce::String(result.renderSeconds, 3) << " s ("
+                  << juce::String(result.getRealtimeMultiple(), 1) << "x realtime, DSP alone "
+                  << juce::String(result.getDspRealtimeMultiple(), 1) << "x)\n";
+        if (result.profile.isNotEmpty())
+            std::cout << result.profile;
+    }
+
+    const double multiple = wallSeconds > 0.0 ? totalAudioSeconds / wallSeconds : 0.0;
+    std::cout << "Total: " << juce::String(totalAudioSeconds, 2) << " s audio in "
+              << juce::String(wallSeconds, 3) << " s on " << settings.numThreads << " threads ("
+              << juce::String(multiple, 1) << "x realtime, "
+              << juce::String(multiple / settings.numThreads, 1)
+              << "x per thread)\n";
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "ParametricEqualizer100/DspProfiler.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+
+// A whole session of EQ instances, run the way a DAW runs its tracks: every
+// audio callback, each instance gets its own block of input and a little
+// automation, and a fixed pool of worker threads (the callback thread being
+// one of them) takes instances off a shared queue until all are done. The
+// callback has one block period to finish.
+//
+// Running many instances at once is what shows the costs a single-instance
+// benchmark hides: per-instance fixed overheads, the working set of hundreds
+// of processors going through the caches each callback, and how well the work
+// spreads over more threads.
+class SessionSimulator {
+public:
+    struct Settings {
+        int numInstances = 64;
+        int numThreads = 1;
+        int numChannels = 2;
+        int blockSize = 128;
+        double sampleRate = 48000.0;
+        double seconds = 5.0;          // of audio per run
+
+        // Share of the instances whose bands are automated every block
+        float automatedFraction = 0.25f;
+
+        // Paced waits out each block period like an audio driver does, so the
+        // caches go cold between callbacks; otherwise callbacks run back to back.
+        bool paced = false;
+
+        // Realtime instances design coefficients on their own design threads, as
+        // they would in a DAW; offline ones design inline
+        bool realtime = true;
+    };
+
+    struct Result {
+        int numCallbacks = 0;
+        int deadlineMisses = 0;                          // callbacks longer than a block period
+        StatisticsHistogram::Summary callbackMicroseconds;
+        double wallSeconds = 0.0;                        // callbacks only, pacing left out
+        double cpuSeconds = 0.0;                         // summed over the workers while busy
+
+        double getBlockPeriodMicroseconds(const Settings&) const;
+        // Instances this machine could keep up with in realtime at this thread
+        // count, judging by throughput alone
+        double getRealtimeInstances(const Settings&) const;
+        // Worker time per instance per callback
+        double getMicrosecondsPerInstanceBlock(const Settings&) const;
+    };
+
+    explicit SessionSimulator(Settings settingsToUse);
+    ~SessionSimulator();
+
+    // Builds and prepares the instances, runs the session and tears it down
+    Result run();
+
+    const Settings& getSettings() const { return settings; }
+
+private:
+    struct Instance;
+    class Worker;
+
+    // Callback side: process instances off the queue until there are none left
+    void processInstances(double& busySeconds);
+    void processInstance(Instance& instance);
+
+    Settings settings;
+
+    std::vector<std::unique_ptr<Instance>> instances;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<int> nextInstance { 0 }, instancesLeft { 0 };
+    int callbackIndex = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (SessionSimulator)
+};
@@ -0,0 +1,139 @@
+#include "ParametricEqualizer100Session/SessionSimulator.h"
+#include <juce_events/juce_events.h>
+#include <iostream>
+
+namespace {
+
+void printUsage() {
+    std::cout
+        << "Usage: ParametricEqualizer100Session [options]\n"
+        << "\n"
+        << "Runs sessions of many EQ instances spread over a pool of threads, as a DAW\n"
+        << "would, and prints callback latency, deadline misses and throughput for every\n"
+        << "combination of instance and thread count.\n"
+        << "\n"
+        << "Options:\n"
+        << "  --instances <list>   Instance counts, e.g. 1,16,64,256 (default)\n"
+        << "  --threads <list>     Thread counts including the callback thread\n"
+        << "                       (default: 1 and powers of two up to the CPU count)\n"
+        << "  --block <samples>    Block size (default: 128)\n"
+        << "  --channels <n>       Channels per instance (default: 2)\n"
+        << "  --seconds <s>        Audio per run (default: 5)\n"
+        << "  --automate <0..1>    Share of instances with automated bands (default: 0.25)\n"
+        << "  --paced              Wait out each block period like an audio driver\n"
+        << "  --offline            Prepare the instances for offline rendering\n";
+}
+
+juce::Array<int> parseList(const juce::String& text) {
+    juce::Array<int> values;
+    for (const auto& token : juce::StringArray::fromTokens(text, ",", {}))
+        if (token.getIntValue() > 0)
+            values.add(token.getIntValue());
+    return values;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    SessionSimulator::Settings settings;
+    juce::Array<int> instanceCounts { 1, 16, 64, 256 };
+    juce::Array<int> threadCounts;
+
+    for (int i = 1; i < argc; ++i) {
+        const juce::String arg(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--instances" && hasValue) {
+            instanceCounts = parseList(argv[++i]);
+        }
+        else if (arg == "--threads" && hasValue) {
+            threadCounts = parseList(argv[++i]);
+        }
+        else if (arg == "--block" && hasValue) {
+            settings.blockSize = juce::String(argv[++i]).getIntValue();
+        }
+        else if (arg == "--channels" && hasValue) {
+            settings.numChannels = juce::String(argv[++i]).getIntValue();
+        }
+        else if (arg == "--seconds" && hasValue) {
+            settings.seconds = juce::String(argv[++i]).getDoubleValue();
+        }
+        else if (arg == "--automate" && hasValue) {
+            settings.automatedFraction = juce::String(argv[++i]).getFloatValue();
+        }
+        else if (arg == "--paced") {
+            settings.paced = true;
+        }
+        else if (arg == "--offline") {
+            settings.realtime = false;
+        }
+        else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        else {
+            std::cerr << "Unknown or incomplete option " << arg << "\n\n";
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (threadCounts.isEmpty()) {
+        const int numCpus = juce::SystemStats::getNumCpus();
+        for (int n = 1; n <= numCpus; n *= 2)
+            threadCounts.add(n);
+    }
+
+    if (instanceCounts.isEmpty() || threadCounts.isEmpty() || settings.blockSize <= 0
+        || settings.numChannels <= 0 || settings.seconds <= 0.0) {
+        printUsage();
+        return 1;
+    }
+
+    std::cout << settings.numChannels << " channels, " << settings.blockSize << " samples at "
+              << juce::String(settings.sampleRate / 1000.0, 1) << " kHz ("
+              << juce::String(1.0e6 * settings.blockSize / settings.sampleRate, 0) << " us per block), "
+              << juce::String(settings.automatedFraction * 100.0f, 0) << "% automated, "
+              << (settings.paced ? "paced" : "back to back") << ", "
+              << (settings.realtime ? "realtime" : "offline") << "\n\n";
+
+    std::cout << juce::String("instances").paddedLeft(' ', 9) << juce::String("threads").paddedLeft(' ', 8)
+              << juce::String("p50 us").paddedLeft(' ', 10) << juce::String("p99 us").paddedLeft(' ', 10)
+              << juce::String("max us").paddedLeft(' ', 10) << juce::String("misses").paddedLeft(' ', 14)
+              << juce::String("us/inst").paddedLeft(' ', 10) << juce::String("rt inst").paddedLeft(' ', 10)
+              << "\n";
+
+    for (const int numThreads : threadCounts) {
+        for (const int numInstances : instanceCounts) {
+            auto runSettings = settings;
+            runSettings.numInstances = numInstances;
+            runSettings.numThreads = numThreads;
+
+            SessionSimulator simulator(runSettings);
+            const auto result = simulator.run();
+            if (result.numCallbacks == 0) {
+                std::cerr << "Couldn't set up " << settings.numChannels << " channel instances\n";
+                return 1;
+            }
+
+            const auto& s = simulator.getSettings();
+            const auto& latency = result.callbackMicroseconds;
+            const juce::String misses = juce::String(result.deadlineMisses) + " ("
+                    + juce::String(100.0 * result.deadlineMisses / result.numCallbacks, 1) + "%)";
+
+            std::cout << juce::String(numInstances).paddedLeft(' ', 9)
+                      << juce::String(numThreads).paddedLeft(' ', 8)
+                      << juce::String(latency.p50, 1).paddedLeft(' ', 10)
+                      << juce::String(latency.p99, 1).paddedLeft(' ', 10)
+                      << juce::String(latency.max, 1).paddedLeft(' ', 10)
+                      << misses.paddedLeft(' ', 14)
+                      << juce::String(result.getMicrosecondsPerInstanceBlock(s), 2).paddedLeft(' ', 10)
+                      << juce::String(result.getRealtimeInstances(s), 0).paddedLeft(' ', 10)
+                      << "\n";
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include "ParametricEqualizer100Session/SessionSimulator.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include <cmath>
+
+namespace {
+
+juce::AudioChannelSet channelSetFor(int numChannels) {
+    auto set = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+    return set.isDisabled() ? juce::AudioChannelSet::discreteChannels(numChannels) : set;
+}
+
+// Input cycles through this many blocks of noise per instance, so the signal
+// stays fresh without generating it on the clock
+constexpr int numSourceBlocks = 8;
+
+// Waits for a point on the high-resolution clock, sleeping while it's far off
+void waitUntil(juce::int64 ticks) {
+    const auto ticksPerMs = juce::Time::getHighResolutionTicksPerSecond() / 1000;
+    for (auto now = juce::Time::getHighResolutionTicks(); now < ticks; now = juce::Time::getHighResolutionTicks()) {
+        if (ticks - now > 2 * ticksPerMs)
+            juce::Thread::sleep(1);
+        else
+            juce::Thread::yield();
+    }
+}
+
+} // namespace
+
+//==============================================================================
+// One track's EQ, with its own input and automation
+struct SessionSimulator::Instance {
+    AudioPluginAudioProcessor processor;
+    juce::AudioBuffer<float> source, buffer;
+    juce::MidiBuffer midi;
+
+    // Frequency and gain of one bell, swept slowly at automationRate
+    bool automated = false;
+    juce::RangedAudioParameter* freq = nullptr;
+    juce::RangedAudioParameter* gain = nullptr;
+    double automationRate = 0.0;
+};
+
+// Sleeps until the callback wakes it, then takes instances off the queue
+class SessionSimulator::Worker final : public juce::Thread {
+public:
+    Worker(SessionSimulator& s, int index)
+        : juce::Thread("Session worker " + juce::String(index)), owner(s) {}
+
+    void run() override {
+        for (;;) {
+            start.wait(-1);
+            if (threadShouldExit())
+                return;
+            owner.processInstances(busySeconds);
+        }
+    }
+
+    void wake() { start.signal(); }
+
+    void stop() {
+        signalThreadShouldExit();
+        start.signal();
+        stopThread(1000);
+    }
+
+    double busySeconds = 0.0;   // read once the thread has stopped
+
+private:
+    SessionSimulator& owner;
+    juce::WaitableEvent start;
+};
+
+//==============================================================================
+double SessionSimulator::Result::getBlockPeriodMicroseconds(const Settings& s) const {
+    return 1.0e6 * s.blockSize / s.sampleRate;
+}
+
+double SessionSimulator::Result::getRealtimeInstances(const Settings& s) const {
+    const double audioSeconds = numCallbacks * s.blockSize / s.sampleRate;
+    return wallSeconds > 0.0 ? s.numInstances * audioSeconds / wallSeconds : 0.0;
+}
+
+double SessionSimulator::Result::getMicrosecondsPerInstanceBlock(const Settings& s) const {
+    const double instanceBlocks = (double) numCallbacks * s.numInstances;
+    return instanceBlocks > 0.0 ? 1.0e6 * cpuSeconds / instanceBlocks : 0.0;
+}
+
+//==============================================================================
+SessionSimulator::SessionSimulator(Settings settingsToUse)
+    : settings(std::move(settingsToUse)) {
+    settings.numInstances = juce::jmax(1, settings.numInstances);
+    settings.numThreads = juce::jmax(1, settings.numThreads);
+    settings.numChannels = juce::jmax(1, settings.numChannels);
+    settings.blockSize = juce::jmax(1, settings.blockSize);
+    settings.automatedFraction = juce::jlimit(0.0f, 1.0f, settings.automatedFraction);
+}
+
+SessionSimulator::~SessionSimulator() {
+    for (auto& worker : workers)
+        worker->stop();
+}
+
+SessionSimulator::Result SessionSimulator::run() {
+    const int numInstances = settings.numInstances;
+    const int blockSize = settings.blockSize;
+
+    // Every instance set up the way a host would, each with its own input. The
+    // bells swept are spread over the instances, and so are the ones automated.
+    instances.clear();
+    for (int i = 0; i < numInstances; ++i) {
+        auto instance = std::make_unique<Instance>();
+        auto& processor = instance->processor;
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSetFor(settings.numChannels));
+        layout.outputBuses.add(channelSetFor(settings.numChannels));
+        if (! processor.setBusesLayout(layout))
+            return {};
+
+        processor.setNonRealtime(! settings.realtime);
+        processor.setRateAndBufferSizeDetails(settings.sampleRate, blockSize);
+        processor.prepareToPlay(settings.sampleRate, blockSize);
+
+        instance->source.setSize(settings.numChannels, numSourceBlocks * blockSize);
+        instance->buffer.setSize(settings.numChannels, blockSize);
+        juce::Random random(i + 1);
+        for (int channel = 0; channel < settings.numChannels; ++channel)
+            for (int n = 0; n < instance->source.getNumSamples(); ++n)
+                instance->source.setSample(channel, n, random.nextFloat() * 0.5f - 0.25f);
+
+        const int band = 1 + i % 3;
+        auto& apvts = processor.getValueTreeState();
+        instance->automated = (int) ((i + 1) * settings.automatedFraction) > (int) (i * settings.automatedFraction);
+        instance->freq = apvts.getParameter(AudioPluginAudioProcessor::getBandParameterID(band, "FREQ"));
+        instance->gain = apvts.getParameter(AudioPluginAudioProcessor::getBandParameterID(band, "GAIN"));
+        instance->automationRate = 0.1 + 0.9 * random.nextDouble();
+
+        instances.push_back(std::move(instance));
+    }
+
+    workers.clear();
+    for (int index = 1; index < settings.numThreads; ++index) {
+        workers.push_back(std::make_unique<Worker>(*this, index));
+        workers.back()->startThread(juce::Thread::Priority::highest);
+    }
+
+    Result result;
+    StatisticsHistogram callbackTimes;
+    const auto ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+    const double periodSeconds = blockSize / settings.sampleRate;
+    const int numCallbacks = juce::jmax(1, (int) std::ceil(settings.seconds / periodSeconds));
+    double callbackBusySeconds = 0.0;
+    auto deadline = juce::Time::getHighResolutionTicks();
+
+    for (callbackIndex = 0; callbackIndex < numCallbacks; ++callbackIndex) {
+        if (settings.paced) {
+            waitUntil(deadline);
+            deadline += (juce::int64) (periodSeconds * ticksPerSecond);
+        }
+
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        // Publish the work, then hand it out; the callback thread takes its share
+        instancesLeft.store(numInstances, std::memory_order_relaxed);
+        nextInstance.store(0, std::memory_order_release);
+        for (auto& worker : workers)
+            worker->wake();
+        processInstances(callbackBusySeconds);
+        while (instancesLeft.load(std::memory_order_acquire) > 0)
+            juce::Thread::yield();
+
+        const double seconds = (double) (juce::Time::getHighResolutionTicks() - start) / ticksPerSecond;
+        callbackTimes.record((std::uint64_t) (seconds * 1.0e9));
+        result.wallSeconds += seconds;
+        if (seconds > periodSeconds)
+            ++result.deadlineMisses;
+    }
+
+    result.numCallbacks = numCallbacks;
+    result.callbackMicroseconds = callbackTimes.summarise(1.0e-3);
+    result.cpuSeconds = callbackBusySeconds;
+    for (auto& worker : workers) {
+        worker->stop();
+        result.cpuSeconds += worker->busySeconds;
+    }
+    workers.clear();
+
+    for (auto& instance : instances)
+        instance->processor.releaseResources();
+    instances.clear();
+    return result;
+}
+
+void SessionSimulator::processInstances(double& busySeconds) {
+    const auto start = juce::Time::getHighResolutionTicks();
+    bool processedAny = false;
+
+    for (int i = nextInstance.fetch_add(1, std::memory_order_acq_rel); i < (int) instances.size();
+         i = nextInstance.fetch_add(1, std::memory_order_acq_rel)) {
+        processInstance(*instances[(size_t) i]);
+        processedAny = true;
+        instancesLeft.fetch_sub(1, std::memory_order_release);
+    }
+
+    if (processedAny)
+        busySeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+}
+
+void SessionSimulator::processInstance(Instance& instance) {
+    // Automation arrives from the host on the audio thread, before the block
+    if (instance.automated) {
+        const double t = (double) callbackIndex * settings.blockSize / settings.sampleRate;
+        const double phase = juce::MathConstants<double>::twoPi * instance.automationRate * t;
+        instance.freq->setValueNotifyingHost(instance.freq->convertTo0to1(
+                (float) (1000.0 * std::exp2(2.0 * std::sin(phase)))));
+        instance.gain->setValueNotifyingHost(instance.gain->convertTo0to1(
+                (float) (6.0 * std::sin(1.3 * phase))));
+    }
+
+    const int blockSize = settings.blockSize;
+    const int sourceStart = (callbackIndex % numSourceBlocks) * blockSize;
+    for (int channel = 0; channel < settings.numChannels; ++channel)
+        instance.buffer.copyFrom(channel, 0, instance.source, channel, sourceStart, blockSize);
+
+    instance.processor.processBlock(instance.buffer, instance.midi);
+}
@@ -0,0 +1,617 @@
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Prepares a processor for the given layout, the way a host would
+bool prepare(AudioPluginAudioProcessor& processor, const juce::AudioChannelSet& set,
+             double sampleRate, int blockSize) {
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(set);
+    layout.outputBuses.add(set);
+
+    if (! processor.setBusesLayout(layout))
+        return false;
+
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+    return true;
+}
+
+// Waits, for a second at most, until the design thread has published
+// everything asked of it
+bool waitForDesign(const AudioPluginAudioProcessor& processor) {
+    const auto deadline = juce::Time::getMillisecondCounter() + 1000;
+    while (processor.isDesignPending()) {
+        if (juce::Time::getMillisecondCounter() > deadline)
+            return false;
+        juce::Thread::yield();
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(AudioProcessor, AcceptsSurroundLayouts) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    AudioPluginAudioProcessor processor;
+
+    for (const auto& set : { juce::AudioChannelSet::mono(),
+                             juce::AudioChannelSet::stereo(),
+                             juce::AudioChannelSet::create5point1(),
+                             juce::AudioChannelSet::create7point1point4(),
+                             juce::AudioChannelSet::discreteChannels(16) }) {
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(set);
+        layout.outputBuses.add(set);
+        EXPECT_TRUE(processor.checkBusesLayoutSupported(layout)) << set.getDescription();
+    }
+}
+
+TEST(AudioProcessor, SurroundChannelsAreFilteredIndependently) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    AudioPluginAudioProcessor processor;
+
+    const auto set = juce::AudioChannelSet::create7point1point4();
+    const int numChannels = set.size();
+    const int blockSize = 256;
+    ASSERT_TRUE(prepare(processor, set, 48000.0, blockSize));
+
+    // An impulse in every channel, each one a block later than the previous
+    // channel's, so shared state would smear one channel's ringing into the next
+    const int length = blockSize * (numChannels + 4);
+    juce::AudioBuffer<float> signal(numChannels, length);
+    signal.clear();
+    for (int channel = 0; channel < numChannels; ++channel)
+        signal.setSample(channel, channel * blockSize, 1.0f);
+
+    juce::MidiBuffer midi;
+    for (int start = 0; start < length; start += blockSize) {
+        juce::AudioBuffer<float> block(signal.getArrayOfWritePointers(), numChannels, start, blockSize);
+        processor.processBlock(block, midi);
+    }
+
+    // Every channel must produce the same impulse response, shifted by its delay
+    for (int channel = 1; channel < numChannels; ++channel) {
+        for (int n = 0; n < length - channel * blockSize; ++n) {
+            EXPECT_FLOAT_EQ(signal.getSample(channel, channel * blockSize + n), signal.getSample(0, n))
+                << "channel " << channel << ", sample " << n;
+            if (::testing::Test::HasFailure())
+                return;
+        }
+        for (int n = 0; n < channel * blockSize; ++n)
+            EXPECT_EQ(signal.getSample(channel, n), 0.0f) << "channel " << channel << ", sample " << n;
+    }
+}
+
+TEST(AudioProcessor, OversamplingKeepsThePassbandAndReportsLatency) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const int blockSize = 512;
+    const int length = blockSize * 32;
+
+    // RMS of a 1 kHz sine through the processor, once it has settled
+    const auto measure = [&](int oversamplingIndex, int& latency) {
+        AudioPluginAudioProcessor processor;
+        auto* oversampling = processor.getValueTreeState().getParameter("OVERSAMPLING");
+        oversampling->setValueNotifyingHost(oversampling->convertTo0to1((float) oversamplingIndex));
+        EXPECT_TRUE(prepare(processor, juce::AudioChannelSet::stereo(), sampleRate, blockSize));
+        latency = processor.getLatencySamples();
+
+        juce::AudioBuffer<float> signal(2, length);
+        for (int n = 0; n < length; ++n)
+            for (int channel = 0; channel < 2; ++channel)
+                signal.setSample(channel, n, (float) std::sin(juce::MathConstants<double>::twoPi * 1000.0 * n / sampleRate));
+
+        juce::MidiBuffer midi;
+        for (int start = 0; start < length; start += blockSize) {
+            juce::AudioBuffer<float> block(signal.getArrayOfWritePointers(), 2, start, blockSize);
+            processor.processBlock(block, midi);
+        }
+        return signal.getRMSLevel(0, length / 2, length / 2);
+    };
+
+    int latency = 0;
+    const float reference = measure(0, latency);
+    EXPECT_EQ(latency, 0);
+
+    for (int index : { 1, 2 }) {
+        const float level = measure(index, latency);
+        EXPECT_GT(latency, 0) << "oversampling index " << index;
+        EXPECT_NEAR(juce::Decibels::gainToDecibels(level),
+                    juce::Decibels::gainToDecibels(reference), 0.05f) << "oversampling index " << index;
+    }
+}
+
+TEST(AudioProcessor, RealtimeDesignThreadReachesTheSameFilterAsOffline) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const int blockSize = 256;
+
+    // Level of a 1 kHz sine through a processor whose band 3 bell gain is moved to
+    // +12 dB after it started playing
+    const auto measure = [&](bool nonRealtime) {
+        AudioPluginAudioProcessor processor;
+        processor.setNonRealtime(nonRealtime);
+        EXPECT_TRUE(prepare(processor, juce::AudioChannelSet::mono(), sampleRate, blockSize));
+
+        auto* gain = processor.getValueTreeState().getParameter("BAND3GAIN");
+        gain->setValueNotifyingHost(gain->convertTo0to1(12.0f));
+
+        juce::AudioBuffer<float> buffer(1, blockSize);
+        juce::MidiBuffer midi;
+        float level = 0.0f;
+        for (int block = 0; block < 400; ++block) {
+            for (int n = 0; n < blockSize; ++n)
+                buffer.setSample(0, n, (float) std::sin(juce::MathConstants<double>::twoPi * 1000.0
+                                                        * (block * blockSize + n) / sampleRate));
+            processor.processBlock(buffer, midi);
+            level = buffer.getRMSLevel(0, 0, blockSize);
+
+            // Let the design thread catch up, as it would between callbacks
+            if (! nonRealtime)
+                EXPECT_TRUE(waitForDesign(processor));
+        }
+        processor.releaseResources();
+        return level;
+    };
+
+    EXPECT_NEAR(juce::Decibels::gainToDecibels(measure(false)),
+                juce::Decibels::gainToDecibels(measure(true)), 0.05f);
+}
+
+TEST(AudioProcessor, BandsThatAreOffPassTheSignalThrough) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const int blockSize = 256;
+
+    AudioPluginAudioProcessor processor;
+    processor.setNonRealtime(true);
+    auto& apvts = processor.getValueTreeState();
+
+    // Every band on, with a boost, then every band off again
+    for (int band = 0; band < AudioPluginAudioProcessor::maxBands; ++band) {
+        auto* gain = apvts.getParameter(AudioPluginAudioProcessor::getBandParameterID(band, "GAIN"));
+        gain->setValueNotifyingHost(gain->convertTo0to1(6.0f));
+        apvts.getParameter(AudioPluginAudioProcessor::getBandParameterID(band, "ON"))->setValueNotifyingHost(1.0f);
+    }
+    ASSERT_TRUE(prepare(processor, juce::AudioChannelSet::stereo(), 48000.0, blockSize));
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    const auto runNoise = [&] {
+        juce::Random random(3);
+        for (int channel = 0; channel < 2; ++channel)
+            for (int n = 0; n < blockSize; ++n)
+                buffer.setSample(channel, n, random.nextFloat() * 2.0f - 1.0f);
+        processor.processBlock(buffer, midi);
+    };
+    runNoise();
+
+    for (int band = 0; band < AudioPluginAudioProcessor::maxBands; ++band)
+        apvts.getParameter(AudioPluginAudioProcessor::getBandParameterID(band, "ON"))->setValueNotifyingHost(0.0f);
+
+    // One block to ramp out, then the input comes back untouched
+    runNoise();
+    for (int block = 0; block < 4; ++block) {
+        runNoise();
+        juce::Random random(3);
+        for (int channel = 0; channel < 2; ++channel)
+            for (int n = 0; n < blockSize; ++n)
+                EXPECT_FLOAT_EQ(buffer.getSample(channel, n), random.nextFloat() * 2.0f - 1.0f)
+                    << "channel " << channel << ", sample " << n;
+    }
+}
+
+TEST(AudioProcessor, DynamicBandTurnsDownOnlyAboveItsThreshold) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const int blockSize = 256;
+    const int numBlocks = 100;
+
+    // Level of a 1 kHz sine at the given amplitude through band 3, a +3 dB bell at
+    // 1 kHz, after it settled
+    const auto measure = [&](float amplitude, bool dynamic) {
+        AudioPluginAudioProcessor processor;
+        processor.setNonRealtime(true);
+        auto& apvts = processor.getValueTreeState();
+        const auto set = [&apvts](const char* suffix, float value) {
+            auto* param = apvts.getParameter(AudioPluginAudioProcessor::getBandParameterID(2, suffix));
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+        };
+        set("DYN", dynamic ? 1.0f : 0.0f);
+        set("THRESH", -30.0f);
+        set("RATIO", 10.0f);
+        set("ATTACK", 1.0f);
+        EXPECT_TRUE(prepare(processor, juce::AudioChannelSet::mono(), sampleRate, blockSize));
+
+        juce::AudioBuffer<float> buffer(1, blockSize);
+        juce::MidiBuffer midi;
+        for (int block = 0; block < numBlocks; ++block) {
+            for (int n = 0; n < blockSize; ++n)
+                buffer.setSample(0, n, amplitude * (float) std::sin(juce::MathConstants<double>::twoPi * 1000.0
+                                                                    * (block * blockSize + n) / sampleRate));
+            processor.processBlock(buffer, midi);
+        }
+        return juce::Decibels::gainToDecibels(buffer.getRMSLevel(0, 0, blockSize));
+    };
+
+    // A sine of amplitude 0.5 reads about -9 dB in the band, well over -30 dB
+    EXPECT_LT(measure(0.5f, true), measure(0.5f, false) - 12.0f);
+
+    // At -49 dB it stays below the threshold and the band is as it was
+    EXPECT_NEAR(measure(0.005f, true), measure(0.005f, false), 0.05f);
+}
+
+TEST(AudioProcessor, ReportsATailThatFollowsTheBands) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    AudioPluginAudioProcessor processor;
+    ASSERT_TRUE(prepare(processor, juce::AudioChannelSet::stereo(), 48000.0, 512));
+    auto& apvts = processor.getValueTreeState();
+    const auto set = [&apvts](const juce::String& id, float value) {
+        auto* param = apvts.getParameter(id);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    };
+
+    const double defaultTail = processor.getTailLengthSeconds();
+    EXPECT_GT(defaultTail, 0.0);
+    EXPECT_LT(defaultTail, 1.0);
+
+    // A narrow bell low down rings for much longer
+    set("BAND2FREQ", 40.0f);
+    set("BAND2GAIN", 12.0f);
+    set("BAND2Q", 10.0f);
+    EXPECT_GT(processor.getTailLengthSeconds(), 2.0 * defaultTail);
+
+    // Linear phase rings for the length of its FIR, whatever the bands
+    set("LINEARPHASE", 1.0f);
+    EXPECT_NEAR(processor.getTailLengthSeconds(), 2.0 * processor.getLatencySamples() / 48000.0, 0.01);
+}
+
+TEST(AudioProcessor, SilentInputGoesIdleOnceTheTailHasRungOut) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const int blockSize = 512;
+
+    AudioPluginAudioProcessor processor;
+    processor.setNonRealtime(true);
+    ASSERT_TRUE(prepare(processor, juce::AudioChannelSet::mono(), sampleRate, blockSize));
+    const int maxBlocks = (int) (processor.getTailLengthSeconds() * sampleRate) / blockSize + 2;
+
+    juce::AudioBuffer<float> buffer(1, blockSize);
+    juce::MidiBuffer midi;
+    const auto runImpulse = [&] {
+        buffer.clear();
+        buffer.setSample(0, 0, 1.0f);
+        processor.processBlock(buffer, midi);
+        return juce::AudioBuffer<float>(buffer);
+    };
+    const auto runUntilIdle = [&] {
+        // The ringing carries on until it's inaudible, then stops dead
+        float lastPeak = 1.0f;
+        int block = 0;
+        for (; block < maxBlocks; ++block) {
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+            const float peak = buffer.getMagnitude(0, 0, blockSize);
+            if (peak == 0.0f)
+                break;
+            lastPeak = peak;
+        }
+        EXPECT_LT(block, maxBlocks);
+        EXPECT_LT(lastPeak, 1.0e-5f);
+    };
+
+    runImpulse();
+    runUntilIdle();
+    const auto first = runImpulse();
+    runUntilIdle();
+
+    // And the next sound starts the filters from silence, as if they'd never slept
+    const auto second = runImpulse();
+    for (int n = 0; n < blockSize; ++n)
+        EXPECT_NEAR(second.getSample(0, n), first.getSample(0, n), 1.0e-6f) << "sample " << n;
+}
+
+TEST(AudioProcessor, DoublePrecisionBlocksMatchFloatBlocks) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const int blockSize = 256;
+    const int numBlocks = 40;
+
+    // The same noise through a float and a double instance, for the plain
+    // cascade and for the paths that take a float copy of double blocks
+    for (int oversamplingIndex : { 0, 1 }) {
+        AudioPluginAudioProcessor floatProcessor, doubleProcessor;
+        for (auto* processor : { &floatProcessor, &doubleProcessor }) {
+            processor->setNonRealtime(true);
+            auto* oversampling = processor->getValueTreeState().getParameter("OVERSAMPLING");
+            oversampling->setValueNotifyingHost(oversampling->convertTo0to1((float) oversamplingIndex));
+            ASSERT_TRUE(prepare(*processor, juce::AudioChannelSet::stereo(), 48000.0, blockSize));
+        }
+        EXPECT_TRUE(doubleProcessor.supportsDoublePrecisionProcessing());
+
+        juce::AudioBuffer<float> floatBuffer(2, blockSize);
+        juce::AudioBuffer<double> doubleBuffer(2, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(5);
+        float worst = 0.0f;
+
+        for (int block = 0; block < numBlocks; ++block) {
+            for (int channel = 0; channel < 2; ++channel) {
+                for (int n = 0; n < blockSize; ++n) {
+                    const float x = random.nextFloat() * 2.0f - 1.0f;
+                    floatBuffer.setSample(channel, n, x);
+                    doubleBuffer.setSample(channel, n, (double) x);
+                }
+            }
+            floatProcessor.processBlock(floatBuffer, midi);
+            doubleProcessor.processBlock(doubleBuffer, midi);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int n = 0; n < blockSize; ++n)
+                    worst = std::max(worst, std::abs(floatBuffer.getSample(channel, n)
+                                                     - (float) doubleBuffer.getSample(channel, n)));
+        }
+        EXPECT_LT(worst, 1.0e-5f) << "oversampling index " << oversamplingIndex;
+    }
+}
+
+TEST(AudioProcessor, StereoModesPutBandsOnOneChannelOrComponent) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const int blockSize = 256;
+    const int numBlocks = 40;
+
+    // Band 3, a +3 dB bell at 1 kHz, on one channel or component against the same
+    // EQ without it; returns the level difference in dB on left and right
+    const auto measure = [&](float stereoMode, float channel, float rightSign) {
+        AudioPluginAudioProcessor placed, without;
+        for (auto* processor : { &placed, &without }) {
+            processor->setNonRealtime(true);
+            auto& apvts = processor->getValueTreeState();
+            const auto set = [&apvts](const juce::String& id, float value) {
+                auto* param = apvts.getParameter(id);
+                param->setValueNotifyingHost(param->convertTo0to1(value));
+            };
+            set("STEREO", stereoMode);
+            set("BAND3CHANNEL", channel);
+            set("BAND3ON", processor == &placed ? 1.0f : 0.0f);
+            EXPECT_TRUE(prepare(*processor, juce::AudioChannelSet::stereo(), sampleRate, blockSize));
+        }
+
+        juce::AudioBuffer<float> a(2, blockSize), b(2, blockSize);
+        juce::MidiBuffer midi;
+        for (int block = 0; block < numBlocks; ++block) {
+            for (int n = 0; n < blockSize; ++n) {
+                const auto x = 0.5f * (float) std::sin(juce::MathConstants<double>::twoPi * 1000.0
+                                                       * (block * blockSize + n) / sampleRate);
+                for (auto* buffer : { &a, &b }) {
+                    buffer->setSample(0, n, x);
+                    buffer->setSample(1, n, rightSign * x);
+                }
+            }
+            placed.processBlock(a, midi);
+            without.processBlock(b, midi);
+        }
+
+        std::array<float, 2> differenceDb {};
+        for (int ch = 0; ch < 2; ++ch)
+            differenceDb[(size_t) ch] = juce::Decibels::gainToDecibels(a.getRMSLevel(ch, 0, blockSize))
+                                      - juce::Decibels::gainToDecibels(b.getRMSLevel(ch, 0, blockSize));
+        return differenceDb;
+    };
+
+    // Left/Right: only the left channel gets the boost
+    const auto left = measure(1.0f, 1.0f, 1.0f);
+    EXPECT_NEAR(left[0], 3.0f, 0.1f);
+    EXPECT_NEAR(left[1], 0.0f, 1.0e-3f);
+
+    // Mid/Side, band on the side: a mono signal is all mid and goes through as it
+    // was, the same signal out of phase is all side and gets the boost
+    const auto mono = measure(2.0f, 2.0f, 1.0f);
+    EXPECT_NEAR(mono[0], 0.0f, 1.0e-3f);
+    EXPECT_NEAR(mono[1], 0.0f, 1.0e-3f);
+
+    const auto side = measure(2.0f, 2.0f, -1.0f);
+    EXPECT_NEAR(side[0], 3.0f, 0.1f);
+    EXPECT_NEAR(side[1], 3.0f, 0.1f);
+
+    // Linked ignores the placement
+    const auto linked = measure(0.0f, 1.0f, 1.0f);
+    EXPECT_NEAR(linked[0], 3.0f, 0.1f);
+    EXPECT_NEAR(linked[1], 3.0f, 0.1f);
+}
+
+TEST(AudioProcessor, PassSlopesSplitIntoButterworthSections) {
+    using P = AudioPluginAudioProcessor;
+    std::array<double, P::maxSectionsPerBand> qs {};
+
+    // 24 dB/oct Butterworth: the fourth-order Qs, lowest first
+    ASSERT_EQ(P::getPassSectionQs(24, false, qs), 2);
+    EXPECT_NEAR(qs[0], 0.5412, 1.0e-4);
+    EXPECT_NEAR(qs[1], 1.3066, 1.0e-4);
+
+    // 24 dB/oct Linkwitz-Riley: two second-order Butterworths
+    ASSERT_EQ(P::getPassSectionQs(24, true, qs), 2);
+    EXPECT_NEAR(qs[0], 0.7071, 1.0e-4);
+    EXPECT_NEAR(qs[1], 0.7071, 1.0e-4);
+
+    // Odd orders start with a first-order section, and Linkwitz-Riley can't have them
+    ASSERT_EQ(P::getPassSectionQs(18, true, qs), 2);
+    EXPECT_EQ(qs[0], 0.0);
+    EXPECT_NEAR(qs[1], 1.0, 1.0e-12);
+
+    for (bool linkwitzRiley : { false, true })
+        EXPECT_EQ(P::getPassSectionQs(96, linkwitzRiley, qs), P::maxSectionsPerBand);
+}
+
+TEST(AudioProcessor, PassSlopesMatchTheirAlignment) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const double cutoff = 1000.0;
+
+    AudioPluginAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails(sampleRate, 256);
+    auto& apvts = processor.getValueTreeState();
+    const auto set = [&apvts](const juce::String& id, float value) {
+        auto* param = apvts.getParameter(id);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    };
+
+    // Band 1 alone
+    for (int band = 1; band < AudioPluginAudioProcessor::maxBands; ++band)
+        set(AudioPluginAudioProcessor::getBandParameterID(band, "ON"), 0.0f);
+    set("BAND1FREQ", (float) cutoff);
+
+    for (int type : { 3, 4 }) {   // high pass, low pass
+        set("BAND1TYPE", (float) type);
+        for (int slopeIndex = 0; slopeIndex < (int) AudioPluginAudioProcessor::passSlopes.size(); ++slopeIndex) {
+            for (bool linkwitzRiley : { false, true }) {
+                set("BAND1SLOPE", (float) slopeIndex);
+                set("BAND1ALIGN", linkwitzRiley ? 1.0f : 0.0f);
+
+                // The bilinear transform maps the analog responses through tan(pi f / fs):
+                // Butterworth is 1 / (1 + r^2N) in power, Linkwitz-Riley 1 / (1 + r^N)
+                // in magnitude, both down at the cutoff by 3 and 6 dB
+                const int order = AudioPluginAudioProcessor::passSlopes[(size_t) slopeIndex] / 6;
+                const bool squared = linkwitzRiley && order % 2 == 0;
+                const auto& curve = processor.getFrequencyResponse(200);
+                for (size_t i = 0; i < curve.frequencies.size(); ++i) {
+                    const double f = curve.frequencies[i];
+                    const double warped = std::tan(juce::MathConstants<double>::pi * f / sampleRate)
+                                        / std::tan(juce::MathConstants<double>::pi * cutoff / sampleRate);
+                    const double r = type == 3 ? 1.0 / warped : warped;
+                    const double expectedDb = squared ? -20.0 * std::log10(1.0 + std::pow(r, order))
+                                                      : -10.0 * std::log10(1.0 + std::pow(r, 2 * order));
+                    if (expectedDb > -150.0)
+                        ASSERT_NEAR(curve.magnitudeDb[i], expectedDb, 0.01 + 1.0e-4 * std::abs(expectedDb))
+                            << "type " << type << ", " << order * 6 << " dB/oct, "
+                            << (squared ? "Linkwitz-Riley" : "Butterworth") << ", " << f << " Hz";
+                }
+            }
+        }
+    }
+}
+
+TEST(AudioProcessor, SteepHighPassFiltersTheAudio) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const int blockSize = 192;   // whole periods of both test frequencies
+    const int numBlocks = 125;
+
+    // Band 1 alone, a 96 dB/oct Butterworth high pass at 1 kHz; returns the level
+    // of a sine at freq, in dB relative to the input, once it has settled
+    const auto measure = [&](double freq) {
+        AudioPluginAudioProcessor processor;
+        processor.setNonRealtime(true);
+        auto& apvts = processor.getValueTreeState();
+        const auto set = [&apvts](const juce::String& id, float value) {
+            auto* param = apvts.getParameter(id);
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+        };
+        for (int band = 1; band < AudioPluginAudioProcessor::maxBands; ++band)
+            set(AudioPluginAudioProcessor::getBandParameterID(band, "ON"), 0.0f);
+        set("BAND1FREQ", 1000.0f);
+        set("BAND1SLOPE", (float) AudioPluginAudioProcessor::passSlopes.size() - 1.0f);
+        EXPECT_TRUE(prepare(processor, juce::AudioChannelSet::stereo(), sampleRate, blockSize));
+
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+        for (int block = 0; block < numBlocks; ++block) {
+            for (int n = 0; n < blockSize; ++n)
+                for (int channel = 0; channel < 2; ++channel)
+                    buffer.setSample(channel, n, 0.5f * (float) std::sin(juce::MathConstants<double>::twoPi * freq
+                                                                        * (block * blockSize + n) / sampleRate));
+            processor.processBlock(buffer, midi);
+        }
+        return juce::Decibels::gainToDecibels(buffer.getRMSLevel(0, 0, blockSize) / (0.5f / std::sqrt(2.0f)), -200.0f);
+    };
+
+    EXPECT_NEAR(measure(4000.0), 0.0f, 0.01f);
+
+    // An octave below the cutoff is 16 orders of 6 dB down, a little more once warped
+    const double warped = std::tan(juce::MathConstants<double>::pi * 1000.0 / sampleRate)
+                        / std::tan(juce::MathConstants<double>::pi * 500.0 / sampleRate);
+    EXPECT_NEAR(measure(500.0), (float) (-10.0 * std::log10(1.0 + std::pow(warped, 32.0))), 0.5f);
+}
+
+TEST(AudioProcessor, StateVariableEngineMatchesTheBiquads) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const int blockSize = 256;
+    const int numBlocks = 40;
+
+    // The default bands plus a steep high pass, on the same noise through one
+    // instance of each engine
+    AudioPluginAudioProcessor biquadProcessor, svfProcessor;
+    for (auto* processor : { &biquadProcessor, &svfProcessor }) {
+        processor->setNonRealtime(true);
+        auto& apvts = processor->getValueTreeState();
+        auto* slope = apvts.getParameter("BAND1SLOPE");
+        slope->setValueNotifyingHost(slope->convertTo0to1((float) AudioPluginAudioProcessor::passSlopes.size() - 1.0f));
+        auto* engine = apvts.getParameter("ENGINE");
+        engine->setValueNotifyingHost(engine->convertTo0to1(processor == &svfProcessor ? 1.0f : 0.0f));
+        ASSERT_TRUE(prepare(*processor, juce::AudioChannelSet::stereo(), 48000.0, blockSize));
+    }
+
+    juce::AudioBuffer<float> biquadBuffer(2, blockSize), svfBuffer(2, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(7);
+    float worst = 0.0f;
+
+    for (int block = 0; block < numBlocks; ++block) {
+        for (int channel = 0; channel < 2; ++channel)
+            for (int n = 0; n < blockSize; ++n)
+                biquadBuffer.setSample(channel, n, random.nextFloat() * 0.5f - 0.25f);
+        svfBuffer.makeCopyOf(biquadBuffer);
+
+        biquadProcessor.processBlock(biquadBuffer, midi);
+        svfProcessor.processBlock(svfBuffer, midi);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int n = 0; n < blockSize; ++n)
+                worst = std::max(worst, std::abs(biquadBuffer.getSample(channel, n) - svfBuffer.getSample(channel, n)));
+    }
+    EXPECT_LT(worst, 1.0e-5f);
+}
+
+TEST(AudioProcessor, StateVariableEngineStaysStableUnderFastAutomation) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const int blockSize = 32;
+    const int numBlocks = 3000;
+
+    AudioPluginAudioProcessor processor;
+    processor.setNonRealtime(true);
+    auto& apvts = processor.getValueTreeState();
+    const auto set = [&apvts](const juce::String& id, float value) {
+        auto* param = apvts.getParameter(id);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    };
+    set("ENGINE", 1.0f);
+    set("BAND2Q", 10.0f);
+    ASSERT_TRUE(prepare(processor, juce::AudioChannelSet::stereo(), sampleRate, blockSize));
+
+    // A narrow bell jumping between 20 Hz and 20 kHz and between the gain
+    // extremes every block, far faster than the smoothing can follow
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(11);
+    float peak = 0.0f;
+
+    for (int block = 0; block < numBlocks; ++block) {
+        const bool up = block % 2 == 0;
+        set("BAND2FREQ", up ? 20000.0f : 20.0f);
+        set("BAND2GAIN", up ? 24.0f : -24.0f);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int n = 0; n < blockSize; ++n)
+                buffer.setSample(channel, n, random.nextFloat() * 0.5f - 0.25f);
+        processor.processBlock(buffer, midi);
+        peak = std::max(peak, buffer.getMagnitude(0, blockSize));
+    }
+
+    // +24 dB is a gain of 16 at most, on input below 0.25
+    EXPECT_TRUE(std::isfinite(peak));
+    EXPECT_LT(peak, 8.0f);
+}
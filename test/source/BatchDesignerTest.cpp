@@ -0,0 +1,150 @@
+#include "ParametricEqualizer100/BatchDesigner.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include <gtest/gtest.h>
+#include <cmath>
+
+TEST(BatchDesigner, SinCosStaysWithinItsBound) {
+    double worst = 0.0;
+    for (int i = 0; i <= 100000; ++i) {
+        const double x = juce::MathConstants<double>::pi * i / 100000.0;
+        double s, c;
+        FastMath::sinCos(x, s, c);
+        worst = std::max({ worst, std::abs(s - std::sin(x)), std::abs(c - std::cos(x)) });
+    }
+    EXPECT_LT(worst, 1.0e-14);
+}
+
+TEST(BatchDesigner, ExpStaysWithinItsBound) {
+    double worst = 0.0;
+    for (int i = -100000; i <= 100000; ++i) {
+        const double x = 50.0 * i / 100000.0;
+        worst = std::max(worst, std::abs(FastMath::exp(x) / std::exp(x) - 1.0));
+    }
+    EXPECT_LT(worst, 5.0e-15);
+}
+
+TEST(BatchDesigner, MatchesTheScalarDesigners) {
+    using P = AudioPluginAudioProcessor;
+    BatchDesigner designer;
+    std::vector<std::array<double,6>> expected;
+
+    for (double sampleRate : { 44100.0, 96000.0 }) {
+        for (double freq = 10.0; freq < 0.49 * sampleRate; freq *= 1.37) {
+            for (double Q : { 0.1, 0.707, 4.0, 10.0 }) {
+                for (double gain : { -24.0, -3.5, 0.0, 6.0, 24.0 }) {
+                    designer.add(FilterType::lowPass, sampleRate, freq, Q);
+                    expected.push_back(P::makeLowPass(sampleRate, freq, Q));
+                    designer.add(FilterType::highPass, sampleRate, freq, Q);
+                    expected.push_back(P::makeHighPass(sampleRate, freq, Q));
+                    designer.add(FilterType::bandPass, sampleRate, freq, Q);
+                    expected.push_back(P::makeBandPass(sampleRate, freq, Q));
+                    designer.add(FilterType::firstOrderLowPass, sampleRate, freq, Q);
+                    expected.push_back(P::makeFirstOrderLowPass(sampleRate, freq));
+                    designer.add(FilterType::firstOrderHighPass, sampleRate, freq, Q);
+                    expected.push_back(P::makeFirstOrderHighPass(sampleRate, freq));
+                    designer.add(FilterType::peaking, sampleRate, freq, Q, gain);
+                    expected.push_back(P::makePeaking(sampleRate, freq, Q, gain));
+
+                    // Shelves with a large Q and gain have no real alpha, see FilterEquivalenceTest
+                    if (std::isnan(P::makeLowShelf(sampleRate, freq, Q, gain)[0]))
+                        continue;
+                    designer.add(FilterType::lowShelf, sampleRate, freq, Q, gain);
+                    expected.push_back(P::makeLowShelf(sampleRate, freq, Q, gain));
+                    designer.add(FilterType::highShelf, sampleRate, freq, Q, gain);
+                    expected.push_back(P::makeHighShelf(sampleRate, freq, Q, gain));
+                }
+            }
+        }
+    }
+    designer.design();
+
+    // Relative to the largest coefficient of each design, after normalising by a0
+    for (int i = 0; i < designer.size(); ++i) {
+        const auto got = designer.getCoefficients(i);
+        const auto& want = expected[(size_t) i];
+        double scale = 0.0;
+        for (int k : { 0, 1, 2, 4, 5 })
+            scale = std::max(scale, std::abs(want[(size_t) k] / want[3]));
+        for (int k : { 0, 1, 2, 4, 5 })
+            ASSERT_NEAR(got[(size_t) k] / got[3], want[(size_t) k] / want[3], 1.0e-12 * scale)
+                << "design " << i << ", coefficient " << k;
+    }
+}
+
+TEST(BatchDesigner, SvfMatchesTheScalarDesigner) {
+    using P = AudioPluginAudioProcessor;
+    BatchDesigner designer;
+    std::vector<SvfCoefficients<double>> expected;
+
+    const FilterType types[] = { FilterType::lowPass, FilterType::highPass, FilterType::bandPass,
+                                 FilterType::firstOrderLowPass, FilterType::firstOrderHighPass,
+                                 FilterType::peaking, FilterType::lowShelf, FilterType::highShelf };
+
+    for (double sampleRate : { 44100.0, 96000.0 }) {
+        for (double freq = 10.0; freq < 0.49 * sampleRate; freq *= 1.37) {
+            for (double Q : { 0.1, 0.707, 4.0, 10.0 }) {
+                for (double gain : { -24.0, -3.5, 0.0, 6.0, 24.0 }) {
+                    for (auto type : types) {
+                        // Shelves with a large Q and gain have no real k either
+                        const auto want = P::makeSvf(type, sampleRate, freq, Q, gain);
+                        if (std::isnan(want.k))
+                            continue;
+                        designer.add(type, sampleRate, freq, Q, gain);
+                        expected.push_back(want);
+                    }
+                }
+            }
+        }
+    }
+    designer.design();
+
+    // Every design is stable in this form, shelves included
+    for (int i = 0; i < designer.size(); ++i) {
+        const auto got = designer.getSvfCoefficients(i);
+        const auto& want = expected[(size_t) i];
+        const double gotValues[] = { got.g, got.k, got.m0, got.m1, got.m2 };
+        const double wantValues[] = { want.g, want.k, want.m0, want.m1, want.m2 };
+        for (size_t k = 0; k < 5; ++k)
+            ASSERT_NEAR(gotValues[k], wantValues[k], 1.0e-12 * std::max(1.0, std::abs(wantValues[k])))
+                << "design " << i << ", parameter " << k;
+    }
+}
+
+TEST(BatchDesigner, DesignsBandsPastNyquistAtNyquist) {
+    // A 20 kHz band at 32 kHz would put w0 past pi, where sinCos has no bound
+    using P = AudioPluginAudioProcessor;
+    const double sampleRate = 32000.0, freq = 20000.0, nyquist = 16000.0;
+
+    BatchDesigner designer;
+    designer.add(FilterType::lowPass, sampleRate, freq, 0.707);
+    designer.add(FilterType::highPass, sampleRate, freq, 0.707);
+    designer.add(FilterType::bandPass, sampleRate, freq, 0.707);
+    designer.add(FilterType::peaking, sampleRate, freq, 0.707, 6.0);
+    designer.add(FilterType::lowShelf, sampleRate, freq, 0.707, 6.0);
+    designer.add(FilterType::highShelf, sampleRate, freq, 0.707, 6.0);
+    designer.add(FilterType::firstOrderLowPass, sampleRate, freq, 0.707);
+    designer.add(FilterType::firstOrderHighPass, sampleRate, freq, 0.707);
+    designer.design();
+
+    const std::array<double,6> expected[] = {
+        P::makeLowPass(sampleRate, nyquist, 0.707),
+        P::makeHighPass(sampleRate, nyquist, 0.707),
+        P::makeBandPass(sampleRate, nyquist, 0.707),
+        P::makePeaking(sampleRate, nyquist, 0.707, 6.0),
+        P::makeLowShelf(sampleRate, nyquist, 0.707, 6.0),
+        P::makeHighShelf(sampleRate, nyquist, 0.707, 6.0),
+        P::makeFirstOrderLowPass(sampleRate, nyquist),
+        P::makeFirstOrderHighPass(sampleRate, nyquist),
+    };
+
+    for (int i = 0; i < designer.size(); ++i) {
+        const auto got = designer.getCoefficients(i);
+        const auto& want = expected[(size_t) i];
+        double scale = 0.0;
+        for (int k : { 0, 1, 2, 4, 5 })
+            scale = std::max(scale, std::abs(want[(size_t) k] / want[3]));
+        for (int k : { 0, 1, 2, 4, 5 })
+            EXPECT_NEAR(got[(size_t) k] / got[3], want[(size_t) k] / want[3], 1.0e-12 * scale)
+                << "design " << i << ", coefficient " << k;
+    }
+}
@@ -0,0 +1,57 @@
+#include "ParametricEqualizer100/DspProfiler.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include <gtest/gtest.h>
+
+TEST(DspProfiler, BucketsCoverEveryValue) {
+    for (std::uint64_t value = 0; value < 100000; ++value) {
+        const int bucket = StatisticsHistogram::getBucket(value);
+        ASSERT_LE(value, StatisticsHistogram::getBucketTop(bucket)) << value;
+        if (bucket > 0)
+            ASSERT_GT(value, StatisticsHistogram::getBucketTop(bucket - 1)) << value;
+    }
+    EXPECT_EQ(StatisticsHistogram::getBucket(UINT64_MAX), StatisticsHistogram::numBuckets - 1);
+}
+
+TEST(DspProfiler, PercentilesAreWithinABucket) {
+    StatisticsHistogram histogram;
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+        histogram.record(value * 1000);
+
+    const auto summary = histogram.summarise(1.0e-3);
+    EXPECT_EQ(summary.count, 1000u);
+    EXPECT_DOUBLE_EQ(summary.max, 1000.0);
+    EXPECT_GE(summary.p50, 500.0);
+    EXPECT_LE(summary.p50, 500.0 * 1.125);
+    EXPECT_GE(summary.p99, 990.0);
+    EXPECT_LE(summary.p99, 1000.0);
+
+    histogram.clear();
+    EXPECT_EQ(histogram.summarise().count, 0u);
+}
+
+TEST(DspProfiler, CountsOneEntryPerProcessedBlock) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    AudioPluginAudioProcessor processor;
+    processor.setNonRealtime(true);
+    processor.prepareToPlay(48000.0, 256);
+
+    juce::AudioBuffer<float> buffer(2, 256);
+    juce::MidiBuffer midi;
+    for (int block = 0; block < 10; ++block) {
+        buffer.clear();
+        processor.processBlock(buffer, midi);
+    }
+
+    const auto statistics = processor.getProfiler().getStatistics();
+    if constexpr (DspProfiler::enabled) {
+        EXPECT_EQ(statistics.blockMicroseconds.count, 10u);
+        // The default high pass, three bells (one at 0 dB) and low pass
+        EXPECT_EQ(statistics.activeBands.max, 4.0);
+        EXPECT_LE(statistics.designMicroseconds.max + statistics.filterMicroseconds.max,
+                  2.0 * statistics.blockMicroseconds.max);
+    }
+    else {
+        EXPECT_EQ(statistics.blockMicroseconds.count, 0u);
+    }
+}
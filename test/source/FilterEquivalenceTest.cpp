@@ -0,0 +1,450 @@
+#include "ParametricEqualizer100/BiquadCascade.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include "ParametricEqualizer100/SvfCascade.h"
+#include <gtest/gtest.h>
+#include <complex>
+#include <functional>
+#include <iostream>
+
+// Checks that every optimised filter kernel matches the RBJ cookbook behaviour of
+// the make* designers. Each candidate runs the designs swept over the parameter
+// ranges from createParameterLayout and is compared against a plain double
+// precision Direct Form I reference on:
+//   - impulse response,
+//   - magnitude and phase on a dense log-spaced grid,
+//   - a null test on noise.
+// New kernels get added to candidates() with their own tolerances. The SVF
+// kernels run the makeSvf() version of each design, so they check it as well.
+
+namespace {
+
+using Coefs = std::array<double,6>;
+using Svf = SvfCoefficients<double>;
+using Signal = std::vector<double>;
+
+constexpr int signalLength = 8192;    // power of two, for the FFT below
+constexpr int numGridPoints = 256;
+
+//==============================================================================
+// Reference: the cookbook difference equation, Direct Form I in double with the
+// raw coefficients exactly as the designers return them.
+Signal referenceFilter(const Coefs& c, const Signal& x) {
+    const double b0 = c[0], b1 = c[1], b2 = c[2];
+    const double a0 = c[3], a1 = c[4], a2 = c[5];
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+    Signal y(x.size());
+    for (size_t n = 0; n < x.size(); ++n) {
+        y[n] = (b0 * x[n] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2) / a0;
+        x2 = x1; x1 = x[n];
+        y2 = y1; y1 = y[n];
+    }
+    return y;
+}
+
+//==============================================================================
+// Candidate kernels
+struct Tolerances {
+    double impulse;           // max |h - h_ref|, relative to max |h_ref|
+    double magnitudeDb;       // max magnitude difference
+    double phaseRadians;      // max phase difference
+    double nullDb;            // noise residual relative to the reference output
+    double floorDb = -60.0;   // magnitude and phase are only compared above this
+};
+
+// Designs swept over the ranges declared in createParameterLayout, as a biquad
+// and as the same filter in state-variable form
+struct DesignCase {
+    std::string description;
+    double sampleRate;
+    double frequency;
+    Coefs coefs;
+    Svf svf;
+};
+
+struct Candidate {
+    const char* name;
+    Tolerances tolerances;
+    std::function<Signal(const DesignCase&, const Signal&)> process;
+
+    // Designs below this fraction of the sample rate are outside what the kernel
+    // is meant to be used for, and are skipped
+    double minRelativeFrequency = 0.0;
+};
+
+template <typename SampleType, typename StateType>
+Signal runBiquadFilter(const Coefs& c, const Signal& x) {
+    BiquadFilter<SampleType, StateType> filter;
+    filter.setCoefficients(c[0], c[1], c[2], c[3], c[4], c[5]);
+
+    Signal y(x.size());
+    for (size_t n = 0; n < x.size(); ++n)
+        y[n] = (double) filter.processSample((SampleType) x[n]);
+    return y;
+}
+
+// The signal goes through lane 0 while lane 1 carries the same signal reversed,
+// so any leak between channels shows up as an error.
+template <typename FloatType>
+Signal runChannelLanes(const Signal& x, int blockSize,
+                       const std::function<void(typename ChannelLanes<FloatType>::Vec*, int, int)>& process) {
+    ChannelLanes<FloatType> lanes;
+    lanes.prepare(2, blockSize);
+
+    Signal y(x.begin(), x.end()), other(x.rbegin(), x.rend());
+    double* channels[] = { y.data(), other.data() };
+
+    for (int start = 0; start < (int) x.size(); start += blockSize) {
+        const int numSamples = juce::jmin(blockSize, (int) x.size() - start);
+        lanes.gather(channels, 2, start, numSamples);
+        for (int group = 0; group < lanes.getNumGroups(); ++group)
+            process(lanes.getGroup(group), numSamples, group);
+        lanes.scatter(channels, 2, start, numSamples);
+    }
+    return y;
+}
+
+template <typename FloatType>
+Signal runBiquadBank(const Coefs& c, const Signal& x) {
+    BiquadBank<FloatType> bank;
+    bank.prepare(ChannelLanes<FloatType>::numGroupsFor(2));
+    bank.setCoefficients(c[0], c[1], c[2], c[3], c[4], c[5]);
+
+    return runChannelLanes<FloatType>(x, 512, [&](auto* frames, int numSamples, int group) {
+        bank.process(frames, numSamples, group);
+    });
+}
+
+// The design sits between two identity sections, which the cascade must skip
+template <typename FloatType>
+Signal runBiquadCascade(const Coefs& c, const Signal& x) {
+    BiquadCascade<FloatType> cascade;
+    cascade.prepare(3, ChannelLanes<FloatType>::numGroupsFor(2));
+    cascade.setCoefficients(1, c[0], c[1], c[2], c[3], c[4], c[5]);
+
+    return runChannelLanes<FloatType>(x, 32, [&](auto* frames, int numSamples, int group) {
+        cascade.process(frames, numSamples, group);
+    });
+}
+
+// The SVF form of the design, in the middle of the chain again
+template <typename FloatType>
+Signal runSvfCascade(const Svf& c, const Signal& x) {
+    SvfCascade<FloatType> cascade;
+    cascade.prepare(3, ChannelLanes<FloatType>::numGroupsFor(2));
+    cascade.setCoefficients(1, c);
+
+    return runChannelLanes<FloatType>(x, 32, [&](auto* frames, int numSamples, int group) {
+        cascade.process(frames, numSamples, group);
+    });
+}
+
+template <Signal (*run)(const Coefs&, const Signal&)>
+Signal biquad(const DesignCase& design, const Signal& x) { return run(design.coefs, x); }
+
+template <Signal (*run)(const Svf&, const Signal&)>
+Signal svf(const DesignCase& design, const Signal& x) { return run(design.svf, x); }
+
+std::vector<Candidate> candidates() {
+    const Tolerances doublePrecision { 1.0e-9, 1.0e-6, 1.0e-6, -150.0 };
+    const Tolerances floatInOut { 1.0e-6, 1.0e-3, 1.0e-3, -120.0 };
+    const Tolerances singlePrecision { 1.0e-4, 0.05, 5.0e-3, -80.0 };
+
+    // A float state loses accuracy quickly as the poles approach z = 1: the null
+    // residual is about -60 dB at 0.001 fs and -50 dB at 0.0005 fs. Float kernels
+    // are only held to account from 0.002 fs (96 Hz at 48 kHz) up.
+    const double singlePrecisionRange = 0.002;
+
+    return {
+        { "BiquadFilter<double, double>", doublePrecision, biquad<runBiquadFilter<double, double>> },
+        { "BiquadFilter<float, double>", floatInOut, biquad<runBiquadFilter<float, double>> },
+        { "BiquadFilter<float, float>", singlePrecision, biquad<runBiquadFilter<float, float>>, singlePrecisionRange },
+        { "BiquadBank<double>", doublePrecision, biquad<runBiquadBank<double>> },
+        { "BiquadBank<float>", singlePrecision, biquad<runBiquadBank<float>>, singlePrecisionRange },
+        { "BiquadCascade<double>", doublePrecision, biquad<runBiquadCascade<double>> },
+        { "BiquadCascade<float>", singlePrecision, biquad<runBiquadCascade<float>>, singlePrecisionRange },
+        { "SvfCascade<double>", doublePrecision, svf<runSvfCascade<double>> },
+        { "SvfCascade<float>", singlePrecision, svf<runSvfCascade<float>>, singlePrecisionRange },
+    };
+}
+
+//==============================================================================
+std::vector<DesignCase> designCases() {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    AudioPluginAudioProcessor processor;
+    auto& apvts = processor.getValueTreeState();
+
+    const auto sweep = [&apvts](const char* id, std::initializer_list<float> positions) {
+        std::vector<double> values;
+        for (float position : positions)
+            values.push_back(apvts.getParameter(id)->convertFrom0to1(position));
+        return values;
+    };
+
+    // Normalised positions, spread so the interesting corners (0 Hz, 20 kHz, the
+    // default Q, the gain extremes and 0 dB) are all hit
+    const auto freqs = sweep("BAND2FREQ", { 0.0f, 0.02f, 0.05f, 0.2f, 0.4f, 0.6f, 0.8f, 1.0f });
+    const auto gains = sweep("BAND2GAIN", { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f });
+    const auto qs = sweep("BAND2Q", { 0.0f, 0.06f, 0.2f, 1.0f });
+
+    using P = AudioPluginAudioProcessor;
+    std::vector<DesignCase> cases;
+
+    const auto add = [&cases](const juce::String& description, double sampleRate,
+                              double frequency, const Coefs& c, const Svf& svf) {
+        // The shelf designers use Q where the cookbook has the shelf slope S, which
+        // has no real solution for high Q at high gain. Those designs come out NaN
+        // in the reference too, so there is nothing to compare.
+        for (double v : c)
+            if (! std::isfinite(v))
+                return;
+        cases.push_back({ description.toStdString(), sampleRate, frequency, c, svf });
+    };
+
+    for (double sampleRate : { 44100.0, 96000.0 }) {
+        const auto sr = " @ " + juce::String(sampleRate) + " Hz";
+
+        for (double f : freqs) {
+            add("high pass " + juce::String(f) + " Hz" + sr, sampleRate, f, P::makeHighPass(sampleRate, f, 0.707),
+                P::makeSvf(FilterType::highPass, sampleRate, f, 0.707));
+            add("low pass " + juce::String(f) + " Hz" + sr, sampleRate, f, P::makeLowPass(sampleRate, f, 0.707),
+                P::makeSvf(FilterType::lowPass, sampleRate, f, 0.707));
+
+            for (double g : gains) {
+                for (double q : qs) {
+                    const auto settings = juce::String(f) + " Hz, " + juce::String(g) + " dB, Q "
+                                        + juce::String(q) + sr;
+                    add("peaking " + settings, sampleRate, f, P::makePeaking(sampleRate, f, q, g),
+                        P::makeSvf(FilterType::peaking, sampleRate, f, q, g));
+                    add("low shelf " + settings, sampleRate, f, P::makeLowShelf(sampleRate, f, q, g),
+                        P::makeSvf(FilterType::lowShelf, sampleRate, f, q, g));
+                    add("high shelf " + settings, sampleRate, f, P::makeHighShelf(sampleRate, f, q, g),
+                        P::makeSvf(FilterType::highShelf, sampleRate, f, q, g));
+                }
+            }
+        }
+    }
+
+    return cases;
+}
+
+//==============================================================================
+// Metrics
+using Spectrum = std::vector<std::complex<double>>;
+
+// Plain radix-2 FFT in double, so the measurement itself adds no float error
+Spectrum fft(const Signal& x) {
+    const size_t size = x.size();
+    Spectrum a(x.begin(), x.end());
+
+    static const Spectrum twiddles = [size] {
+        Spectrum w(size / 2);
+        for (size_t k = 0; k < w.size(); ++k)
+            w[k] = std::polar(1.0, -2.0 * juce::MathConstants<double>::pi * (double) k / (double) size);
+        return w;
+    }();
+    jassert(twiddles.size() * 2 == size);
+
+    for (size_t i = 1, j = 0; i < size; ++i) {
+        size_t bit = size >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+
+    for (size_t length = 2; length <= size; length <<= 1) {
+        const size_t half = length / 2, stride = size / length;
+        for (size_t i = 0; i < size; i += length) {
+            for (size_t k = 0; k < half; ++k) {
+                const auto u = a[i + k], v = a[i + k + half] * twiddles[k * stride];
+                a[i + k] = u + v;
+                a[i + k + half] = u - v;
+            }
+        }
+    }
+    return a;
+}
+
+// FFT bins closest to numGridPoints log-spaced frequencies from 10 Hz to Nyquist
+std::vector<size_t> logGridBins(double sampleRate) {
+    std::vector<size_t> bins;
+    const double lo = std::log(10.0), hi = std::log(sampleRate * 0.5);
+
+    for (int i = 0; i < numGridPoints; ++i) {
+        const double freq = std::exp(lo + (hi - lo) * i / (numGridPoints - 1));
+        const auto bin = (size_t) juce::jlimit(1.0, signalLength / 2.0,
+                                               std::round(freq / sampleRate * signalLength));
+        if (bins.empty() || bins.back() != bin)
+            bins.push_back(bin);
+    }
+    return bins;
+}
+
+double maxAbs(const Signal& x) {
+    double m = 0.0;
+    for (double v : x)
+        m = std::max(m, std::abs(v));
+    return m;
+}
+
+double impulseError(const Signal& reference, const Signal& candidate) {
+    double error = 0.0;
+    for (size_t n = 0; n < reference.size(); ++n)
+        error = std::max(error, std::abs(candidate[n] - reference[n]));
+    return error / std::max(maxAbs(reference), 1.0e-30);
+}
+
+struct ResponseError {
+    double magnitudeDb = 0.0;
+    double phaseRadians = 0.0;
+};
+
+// Both impulse responses are truncated to the same length, so comparing their
+// spectra compares the kernels and not the truncation.
+ResponseError responseError(const Spectrum& reference, const Spectrum& candidate,
+                            const std::vector<size_t>& bins, double floorDb) {
+    ResponseError error;
+    for (size_t bin : bins) {
+        const double refMag = std::abs(reference[bin]);
+        if (juce::Decibels::gainToDecibels(refMag, -400.0) < floorDb)
+            continue;
+
+        const double magDb = 20.0 * std::log10(std::max(std::abs(candidate[bin]), 1.0e-20) / refMag);
+        const double phase = std::abs(std::arg(candidate[bin] / reference[bin]));
+        error.magnitudeDb = std::max(error.magnitudeDb, std::abs(magDb));
+        error.phaseRadians = std::max(error.phaseRadians, phase);
+    }
+    return error;
+}
+
+double nullResidualDb(const Signal& reference, const Signal& candidate) {
+    double residual = 0.0, energy = 0.0;
+    for (size_t n = 0; n < reference.size(); ++n) {
+        residual += (candidate[n] - reference[n]) * (candidate[n] - reference[n]);
+        energy += reference[n] * reference[n];
+    }
+
+    // A design that outputs silence (e.g. a low pass at 0 Hz) must stay silent
+    if (energy < 1.0e-30)
+        return residual < 1.0e-30 ? -400.0 : 0.0;
+
+    return 10.0 * std::log10(std::max(residual, 1.0e-40) / energy);
+}
+
+//==============================================================================
+// Worst case of every metric for one candidate across the whole sweep
+struct Report {
+    std::string name;
+    Tolerances tolerances;
+    double impulse = 0.0, magnitudeDb = 0.0, phaseRadians = 0.0, nullDb = -400.0;
+    std::string worstImpulse, worstMagnitude, worstPhase, worstNull;
+};
+
+const std::vector<Report>& sweepReports() {
+    static const std::vector<Report> reports = [] {
+        const auto kernels = candidates();
+        const auto cases = designCases();
+
+        std::vector<Report> result;
+        for (const auto& kernel : kernels)
+            result.push_back({ kernel.name, kernel.tolerances, 0.0, 0.0, 0.0, -400.0, {}, {}, {}, {} });
+
+        Signal impulse(signalLength, 0.0), noise(signalLength);
+        impulse[0] = 1.0;
+        juce::Random random(2024);
+        for (auto& v : noise)
+            v = random.nextDouble() - 0.5;
+
+        for (const auto& design : cases) {
+            const auto bins = logGridBins(design.sampleRate);
+            const auto refImpulse = referenceFilter(design.coefs, impulse);
+            const auto refSpectrum = fft(refImpulse);
+            const auto refNoise = referenceFilter(design.coefs, noise);
+
+            for (size_t k = 0; k < kernels.size(); ++k) {
+                if (design.frequency < kernels[k].minRelativeFrequency * design.sampleRate)
+                    continue;
+
+                auto& report = result[k];
+                const auto candidateImpulse = kernels[k].process(design, impulse);
+                const auto candidateNoise = kernels[k].process(design, noise);
+
+                const double ir = impulseError(refImpulse, candidateImpulse);
+                const auto response = responseError(refSpectrum, fft(candidateImpulse), bins,
+                                                    report.tolerances.floorDb);
+                const double null = nullResidualDb(refNoise, candidateNoise);
+
+                if (ir > report.impulse) {
+                    report.impulse = ir;
+                    report.worstImpulse = design.description;
+                }
+                if (response.magnitudeDb > report.magnitudeDb) {
+                    report.magnitudeDb = response.magnitudeDb;
+                    report.worstMagnitude = design.description;
+                }
+                if (response.phaseRadians > report.phaseRadians) {
+                    report.phaseRadians = response.phaseRadians;
+                    report.worstPhase = design.description;
+                }
+                if (null > report.nullDb) {
+                    report.nullDb = null;
+                    report.worstNull = design.description;
+                }
+            }
+        }
+
+        for (const auto& report : result)
+            std::cout << "[ measured ] " << report.name
+                      << ": impulse " << report.impulse
+                      << ", magnitude " << report.magnitudeDb << " dB"
+                      << ", phase " << report.phaseRadians << " rad"
+                      << ", null " << report.nullDb << " dB ("
+                      << cases.size() << " designs)\n";
+
+        return result;
+    }();
+
+    return reports;
+}
+
+} // namespace
+
+//==============================================================================
+TEST(FilterEquivalence, ReferenceHitsRequestedGain) {
+    // Sanity check of the harness itself: a 1 kHz bell at +6 dB peaks at +6 dB
+    const double sampleRate = 48000.0;
+    const auto coefs = AudioPluginAudioProcessor::makePeaking(sampleRate, 1000.0, 1.0, 6.0);
+
+    Signal impulse(signalLength, 0.0);
+    impulse[0] = 1.0;
+    const auto spectrum = fft(referenceFilter(coefs, impulse));
+    const auto bin = (size_t) std::round(1000.0 / sampleRate * signalLength);
+
+    EXPECT_NEAR(juce::Decibels::gainToDecibels(std::abs(spectrum[bin])), 6.0, 0.01);
+}
+
+TEST(FilterEquivalence, ImpulseResponses) {
+    for (const auto& report : sweepReports())
+        EXPECT_LE(report.impulse, report.tolerances.impulse)
+            << report.name << ", worst case " << report.worstImpulse;
+}
+
+TEST(FilterEquivalence, MagnitudeResponses) {
+    for (const auto& report : sweepReports())
+        EXPECT_LE(report.magnitudeDb, report.tolerances.magnitudeDb)
+            << report.name << ", worst case " << report.worstMagnitude;
+}
+
+TEST(FilterEquivalence, PhaseResponses) {
+    for (const auto& report : sweepReports())
+        EXPECT_LE(report.phaseRadians, report.tolerances.phaseRadians)
+            << report.name << ", worst case " << report.worstPhase;
+}
+
+TEST(FilterEquivalence, NullTests) {
+    for (const auto& report : sweepReports())
+        EXPECT_LE(report.nullDb, report.tolerances.nullDb)
+            << report.name << ", worst case " << report.worstNull;
+}
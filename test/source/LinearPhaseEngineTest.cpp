@@ -0,0 +1,83 @@
+#include "ParametricEqualizer100/LinearPhaseEngine.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <complex>
+
+namespace {
+
+// Magnitude of the FIR at f Hz, straight from the DTFT
+double firMagnitudeDb(const juce::AudioBuffer<float>& ir, double f, double sampleRate) {
+    const double w = juce::MathConstants<double>::twoPi * f / sampleRate;
+    std::complex<double> sum = 0.0;
+    const auto* h = ir.getReadPointer(0);
+    for (int n = 0; n < ir.getNumSamples(); ++n)
+        sum += (double) h[n] * std::polar(1.0, -w * n);
+    return 20.0 * std::log10(std::abs(sum));
+}
+
+} // namespace
+
+TEST(LinearPhaseEngine, KernelMatchesTheCascadeMagnitude) {
+    const double sampleRate = 48000.0;
+    const std::vector<std::array<double,6>> bands {
+        AudioPluginAudioProcessor::makeHighPass(sampleRate, 80.0, 0.707),
+        AudioPluginAudioProcessor::makePeaking(sampleRate, 1000.0, 1.0, 6.0),
+        AudioPluginAudioProcessor::makeHighShelf(sampleRate, 8000.0, 0.707, -4.0),
+        AudioPluginAudioProcessor::makeLowPass(sampleRate, 18000.0, 0.707),
+    };
+
+    const int firLength = LinearPhaseEngine::firLengthFor(sampleRate);
+    juce::AudioBuffer<float> ir;
+    LinearPhaseEngine::designImpulseResponse(bands, firLength, ir);
+    ASSERT_EQ(ir.getNumSamples(), firLength);
+
+    // Symmetric about the centre tap, so every frequency is delayed the same
+    const auto* h = ir.getReadPointer(0);
+    const int half = firLength / 2;
+    for (int n = 1; n < half; ++n)
+        ASSERT_NEAR(h[half + n], h[half - n], 1.0e-6f) << "tap " << n;
+
+    for (double f : { 80.0, 200.0, 1000.0, 3000.0, 10000.0, 16000.0 }) {
+        double expected = 1.0;
+        for (const auto& c : bands)
+            expected *= BiquadCoefficients<double>::normalised(c[0], c[1], c[2], c[3], c[4], c[5])
+                            .getMagnitude(juce::MathConstants<double>::twoPi * f / sampleRate);
+        EXPECT_NEAR(firMagnitudeDb(ir, f, sampleRate), 20.0 * std::log10(expected), 0.05)
+            << f << " Hz";
+    }
+}
+
+TEST(LinearPhaseEngine, ProcessorReportsTheKernelLatency) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    AudioPluginAudioProcessor processor;
+    auto* linearPhase = processor.getValueTreeState().getParameter("LINEARPHASE");
+    ASSERT_NE(linearPhase, nullptr);
+
+    // Offline the engine is built at the next block rather than on the message thread
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(48000.0, 512);
+    processor.prepareToPlay(48000.0, 512);
+    EXPECT_EQ(processor.getLatencySamples(), 0);
+
+    // A block of sound, so the filters aren't asleep
+    juce::AudioBuffer<float> buffer(2, 512);
+    juce::MidiBuffer midi;
+    const auto play = [&] {
+        for (int channel = 0; channel < 2; ++channel)
+            for (int n = 0; n < 512; ++n)
+                buffer.setSample(channel, n, 0.1f);
+        processor.processBlock(buffer, midi);
+    };
+
+    // The delay is only reported once the engine is actually running
+    linearPhase->setValueNotifyingHost(1.0f);
+    EXPECT_EQ(processor.getLatencySamples(), 0);
+    play();
+    EXPECT_EQ(processor.getLatencySamples(), LinearPhaseEngine::firLengthFor(48000.0) / 2);
+
+    linearPhase->setValueNotifyingHost(0.0f);
+    play();
+    EXPECT_EQ(processor.getLatencySamples(), 0);
+    processor.releaseResources();
+}
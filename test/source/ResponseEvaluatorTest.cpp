@@ -0,0 +1,109 @@
+#include "ParametricEqualizer100/ResponseEvaluator.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <complex>
+
+namespace {
+
+std::complex<double> response(const std::array<double,6>& c, double w) {
+    const auto z1 = std::polar(1.0, -w), z2 = std::polar(1.0, -2.0 * w);
+    return (c[0] + c[1] * z1 + c[2] * z2) / (c[3] + c[4] * z1 + c[5] * z2);
+}
+
+} // namespace
+
+TEST(ResponseEvaluator, MatchesTheCascadeResponse) {
+    const double sampleRate = 48000.0;
+    const std::vector<std::array<double,6>> bands {
+        AudioPluginAudioProcessor::makeHighPass(sampleRate, 60.0, 0.707),
+        AudioPluginAudioProcessor::makeLowShelf(sampleRate, 200.0, 0.707, 4.0),
+        AudioPluginAudioProcessor::makePeaking(sampleRate, 2000.0, 3.0, -9.0),
+        AudioPluginAudioProcessor::makeLowPass(sampleRate, 15000.0, 0.707),
+    };
+
+    ResponseEvaluator evaluator;
+    evaluator.setGrid(512, sampleRate);
+    ASSERT_TRUE(evaluator.update(bands));
+    const auto& curve = evaluator.getCurve();
+
+    ASSERT_EQ(curve.frequencies.size(), 512u);
+    EXPECT_NEAR(curve.frequencies.front(), 20.0f, 1.0e-3f);
+    EXPECT_NEAR(curve.frequencies.back(), 20000.0f, 1.0e-1f);
+
+    for (size_t i = 0; i < curve.frequencies.size(); ++i) {
+        const double w = juce::MathConstants<double>::twoPi * curve.frequencies[i] / sampleRate;
+        std::complex<double> h = 1.0;
+        for (const auto& c : bands)
+            h *= response(c, w);
+
+        EXPECT_NEAR(curve.magnitudeDb[i], 20.0 * std::log10(std::abs(h)), 1.0e-3) << curve.frequencies[i] << " Hz";
+        EXPECT_NEAR(std::remainder((double) curve.phaseRadians[i] - std::arg(h), juce::MathConstants<double>::twoPi),
+                    0.0, 1.0e-4) << curve.frequencies[i] << " Hz";
+    }
+}
+
+TEST(ResponseEvaluator, OnlyChangesWhenTheBandsDo) {
+    const double sampleRate = 44100.0;
+    std::vector<std::array<double,6>> bands {
+        AudioPluginAudioProcessor::makePeaking(sampleRate, 1000.0, 1.0, 6.0),
+        AudioPluginAudioProcessor::makePeaking(sampleRate, 5000.0, 1.0, -3.0),
+    };
+
+    ResponseEvaluator evaluator;
+    evaluator.setGrid(256, sampleRate);
+    EXPECT_TRUE(evaluator.update(bands));
+    const int version = evaluator.getCurve().version;
+
+    EXPECT_FALSE(evaluator.update(bands));
+    evaluator.setGrid(256, sampleRate);
+    EXPECT_FALSE(evaluator.update(bands));
+    EXPECT_EQ(evaluator.getCurve().version, version);
+
+    bands[1] = AudioPluginAudioProcessor::makePeaking(sampleRate, 5000.0, 1.0, -6.0);
+    EXPECT_TRUE(evaluator.update(bands));
+    EXPECT_EQ(evaluator.getCurve().version, version + 1);
+
+    // The curve is the sum of the bands, so the first band's contribution is unchanged
+    ResponseEvaluator fresh;
+    fresh.setGrid(256, sampleRate);
+    fresh.update(bands);
+    for (size_t i = 0; i < fresh.getCurve().magnitudeDb.size(); ++i)
+        EXPECT_FLOAT_EQ(evaluator.getCurve().magnitudeDb[i], fresh.getCurve().magnitudeDb[i]);
+}
+
+TEST(ResponseEvaluator, BandsOfSeveralSectionsAddUp) {
+    const double sampleRate = 48000.0;
+    const std::array<std::array<double,6>, 2> highPass {
+        AudioPluginAudioProcessor::makeHighPass(sampleRate, 100.0, 0.54),
+        AudioPluginAudioProcessor::makeHighPass(sampleRate, 100.0, 1.31),
+    };
+    const auto bell = AudioPluginAudioProcessor::makePeaking(sampleRate, 3000.0, 2.0, 5.0);
+
+    ResponseEvaluator flat;
+    flat.setGrid(256, sampleRate);
+    flat.update({ highPass[0], highPass[1], bell });
+
+    // The same sections as two bands, the first of them two sections long
+    ResponseEvaluator banded;
+    banded.setGrid(256, sampleRate);
+    banded.setNumBands(2);
+    banded.setBand(0, highPass.data(), 2);
+    banded.setBand(1, &bell, 1);
+    EXPECT_TRUE(banded.update());
+    for (size_t i = 0; i < flat.getCurve().magnitudeDb.size(); ++i)
+        EXPECT_NEAR(banded.getCurve().magnitudeDb[i], flat.getCurve().magnitudeDb[i], 1.0e-4f);
+
+    // Setting a band to what it already is changes nothing, and a band going
+    // off is just that band
+    banded.setBand(1, &bell, 1);
+    EXPECT_FALSE(banded.update());
+    banded.setBand(0, nullptr, 0);
+    EXPECT_TRUE(banded.update());
+
+    ResponseEvaluator bellOnly;
+    bellOnly.setGrid(256, sampleRate);
+    bellOnly.update({ bell });
+    for (size_t i = 0; i < bellOnly.getCurve().magnitudeDb.size(); ++i)
+        EXPECT_NEAR(banded.getCurve().magnitudeDb[i], bellOnly.getCurve().magnitudeDb[i], 1.0e-4f);
+}
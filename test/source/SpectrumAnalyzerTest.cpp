@@ -0,0 +1,69 @@
+#include "ParametricEqualizer100/SpectrumAnalyzer.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Pushes a stereo sine in blocks, like processBlock would
+void pushSine(SpectrumAnalyzer& analyzer, SpectrumAnalyzer::Tap tap, double frequency,
+              float amplitude, double sampleRate, int numSamples) {
+    const int blockSize = 512;
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    for (int start = 0; start < numSamples; start += blockSize) {
+        for (int n = 0; n < blockSize; ++n)
+            for (int channel = 0; channel < 2; ++channel)
+                buffer.setSample(channel, n, amplitude * (float) std::sin(
+                        juce::MathConstants<double>::twoPi * frequency * (start + n) / sampleRate));
+        analyzer.push(tap, buffer.getArrayOfReadPointers(), 2, blockSize);
+        juce::Thread::sleep(2);
+    }
+}
+
+} // namespace
+
+TEST(SpectrumAnalyzer, FindsASineAtItsLevel) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const double sampleRate = 48000.0;
+    const double frequency = 1000.0;
+
+    SpectrumAnalyzer analyzer;
+    analyzer.prepare(sampleRate);
+    analyzer.setEnabled(true);
+    pushSine(analyzer, SpectrumAnalyzer::postTap, frequency, 0.5f, sampleRate, (int) sampleRate);
+
+    // Give the analyzer thread a moment to catch up with the FIFO
+    SpectrumAnalyzer::Frame frame;
+    juce::Thread::sleep(200);
+    ASSERT_TRUE(analyzer.getFrame(SpectrumAnalyzer::postTap, frame));
+    ASSERT_EQ(frame.averageDb.size(), (size_t) SpectrumAnalyzer::numBins);
+    EXPECT_EQ(frame.sampleRate, sampleRate);
+
+    const auto peakBin = (size_t) std::distance(
+            frame.averageDb.begin(), std::max_element(frame.averageDb.begin(), frame.averageDb.end()));
+    EXPECT_NEAR((double) peakBin * sampleRate / SpectrumAnalyzer::fftSize, frequency,
+                sampleRate / SpectrumAnalyzer::fftSize);
+    EXPECT_NEAR(frame.peakDb[peakBin], juce::Decibels::gainToDecibels(0.5f), 1.5f);
+
+    // Nothing reached the other tap
+    ASSERT_TRUE(analyzer.getFrame(SpectrumAnalyzer::preTap, frame));
+    EXPECT_EQ(frame.version, 0);
+    analyzer.setEnabled(false);
+}
+
+TEST(SpectrumAnalyzer, DisabledIgnoresTheAudio) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    SpectrumAnalyzer analyzer;
+    analyzer.prepare(44100.0);
+    EXPECT_FALSE(analyzer.isEnabled());
+
+    pushSine(analyzer, SpectrumAnalyzer::preTap, 440.0, 0.5f, 44100.0, 44100 / 4);
+
+    // Turning it on afterwards finds nothing queued up
+    analyzer.setEnabled(true);
+    juce::Thread::sleep(100);
+    SpectrumAnalyzer::Frame frame;
+    analyzer.getFrame(SpectrumAnalyzer::preTap, frame);
+    EXPECT_EQ(frame.version, 0);
+    analyzer.setEnabled(false);
+}
@@ -0,0 +1,127 @@
+#include "ParametricEqualizer100/BinaryState.h"
+#include "ParametricEqualizer100/PluginProcessor.h"
+#include "ParametricEqualizer100/PresetBank.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+void setParameter(AudioPluginAudioProcessor& processor, const juce::String& id, float value) {
+    auto* param = processor.getValueTreeState().getParameter(id);
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+float getParameter(AudioPluginAudioProcessor& processor, const juce::String& id) {
+    return processor.getValueTreeState().getRawParameterValue(id)->load();
+}
+
+juce::MemoryBlock stateWith(float freq, float gain) {
+    AudioPluginAudioProcessor processor;
+    setParameter(processor, "BAND3FREQ", freq);
+    setParameter(processor, "BAND3GAIN", gain);
+    juce::MemoryBlock state;
+    processor.getStateInformation(state);
+    return state;
+}
+
+} // namespace
+
+TEST(State, RoundTripsEveryParameter) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    AudioPluginAudioProcessor source;
+    setParameter(source, "BAND3FREQ", 2500.0f);
+    setParameter(source, "BAND3GAIN", -7.5f);
+    setParameter(source, "BAND7ON", 1.0f);
+    setParameter(source, "BAND7TYPE", 2.0f);
+    setParameter(source, "BAND24RELEASE", 750.0f);
+    setParameter(source, "OVERSAMPLING", 1.0f);
+
+    juce::MemoryBlock state;
+    source.getStateInformation(state);
+    EXPECT_EQ(state.getSize(), BinaryState::headerSize
+                               + (size_t) source.getParameters().size() * BinaryState::entrySize);
+
+    AudioPluginAudioProcessor restored;
+    restored.setStateInformation(state.getData(), (int) state.getSize());
+
+    for (auto* param : source.getParameters()) {
+        const auto& id = dynamic_cast<juce::AudioProcessorParameterWithID&>(*param).paramID;
+        const float expected = getParameter(source, id);
+        EXPECT_NEAR(getParameter(restored, id), expected, 1.0e-5f * std::max(1.0f, std::abs(expected))) << id;
+    }
+}
+
+TEST(State, MatchesParametersByIDInAnyOrder) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    // Two known parameters out of order, and one this version doesn't have
+    std::vector<BinaryState::Entry> entries {
+        { BinaryState::hashParameterID("BAND5FREQ"), 12000.0f },
+        { BinaryState::hashParameterID("NOSUCHPARAMETER"), 1.0f },
+        { BinaryState::hashParameterID("BAND1FREQ"), 80.0f },
+    };
+    juce::MemoryBlock state;
+    BinaryState::write(entries, state);
+
+    AudioPluginAudioProcessor processor;
+    processor.setStateInformation(state.getData(), (int) state.getSize());
+    EXPECT_NEAR(getParameter(processor, "BAND5FREQ"), 12000.0f, 0.01f);
+    EXPECT_NEAR(getParameter(processor, "BAND1FREQ"), 80.0f, 0.01f);
+    EXPECT_NEAR(getParameter(processor, "BAND3FREQ"), 1000.0f, 0.01f);
+}
+
+TEST(State, IgnoresDataItCannotRead) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    AudioPluginAudioProcessor processor;
+    setParameter(processor, "BAND3GAIN", 9.0f);
+
+    auto state = stateWith(2500.0f, -7.5f);
+
+    // Truncated, from a newer version, and not a state at all
+    processor.setStateInformation(state.getData(), (int) state.getSize() - 9);
+    static_cast<char*>(state.getData())[4] = 2;
+    processor.setStateInformation(state.getData(), (int) state.getSize());
+    const char xml[] = "<PARAMS/>";
+    processor.setStateInformation(xml, (int) sizeof(xml));
+
+    EXPECT_FLOAT_EQ(getParameter(processor, "BAND3GAIN"), 9.0f);
+}
+
+TEST(State, PresetBankLoadsPresetsOutOfTheMapping) {
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto file = juce::File::createTempFile("peqb");
+
+    std::vector<PresetBank::Preset> presets;
+    for (int i = 0; i < 50; ++i)
+        presets.push_back({ "Preset " + juce::String(i), stateWith(100.0f + 100.0f * (float) i, (float) (i % 24)) });
+    ASSERT_TRUE(PresetBank::write(file, presets));
+
+    PresetBank bank;
+    ASSERT_TRUE(bank.open(file));
+    ASSERT_EQ(bank.getNumPresets(), 50);
+    EXPECT_EQ(bank.getPresetName(0), "Preset 0");
+    EXPECT_EQ(bank.getPresetName(49), "Preset 49");
+    EXPECT_EQ(bank.getPresetName(50), juce::String());
+
+    // The processor offers the bank as its programs
+    AudioPluginAudioProcessor processor;
+    ASSERT_TRUE(processor.loadPresetBank(file));
+    ASSERT_EQ(processor.getNumPrograms(), 50);
+    EXPECT_EQ(processor.getProgramName(37), "Preset 37");
+    processor.setCurrentProgram(37);
+    EXPECT_EQ(processor.getCurrentProgram(), 37);
+    EXPECT_NEAR(getParameter(processor, "BAND3FREQ"), 3800.0f, 0.01f);
+    EXPECT_NEAR(getParameter(processor, "BAND3GAIN"), 13.0f, 0.01f);
+
+    // A file cut short fails to open rather than reading past the end
+    bank.close();
+    juce::MemoryBlock contents;
+    file.loadFileAsData(contents);
+    file.replaceWithData(contents.getData(), contents.getSize() - 10);
+    EXPECT_FALSE(bank.open(file));
+    EXPECT_EQ(bank.getNumPresets(), 0);
+
+    file.deleteFile();
+}